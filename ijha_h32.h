@@ -114,6 +114,9 @@ which means that in *ONE* source file, put:
    // if custom assert wanted (and no dependencies on assert.h)
    #define IJHA_H32_assert   custom_assert
    // #define IJHA_H32_NO_THREADSAFE_SUPPORT // to disable the thread-safe versions
+   // #define IJHA_H32_NO_WAIT_SUPPORT // to disable 'ijha_h32_acquire_wait' (futex/WaitOnAddress)
+   // #define IJHA_H32_ACQUIRE_NEAR_MAX_PROBES 16 // freelist nodes inspected by 'ijha_h32_acquire_near'
+   // #define IJHA_H32_ACQUIRE_NEAR_WINDOW_BYTES 4096 // max distance from hint in 'ijha_h32_acquire_near'
    #include "ijha_h32.h"
 
 Other source files should just include ijha_h32.h
@@ -130,6 +133,12 @@ REVISIONS
                     *Breaking Change*
                     Removed unused flags parameter from 'ijha_h32_memory_size_needed'.
                     When upgrading just remove 'ijha_flags' parameter from call (last parameter)
+   1.2 (2026-10-16) Added position independent 'struct ijha_h32_shared' for
+                    memory shared between processes
+                    Added 'ijha_h32_invalidate_all'
+                    Added 'ijha_h32_acquire_range' and 'ijha_h32_release_range'
+                    Added 'ijha_h32_acquire_near'
+                    Added 'ijha_h32_acquire_wait'
 
 References:
    [1] https://floooh.github.io/2018/06/17/handles-vs-pointers.html
@@ -153,6 +162,19 @@ References:
 
 #define IJHA_H32_INVALID_INDEX ((unsigned)-1)
 
+#ifdef _MSC_VER
+   typedef unsigned __int64 ijha_h32_uint64;
+#elif defined(__GNUC__)
+   __extension__ typedef unsigned long long ijha_h32_uint64;
+#else
+   typedef unsigned long long ijha_h32_uint64;
+#endif
+
+/* 'ijha_h32_acquire_wait' is only available with futex (Linux) or WaitOnAddress (Windows) */
+#if !defined(IJHA_H32_NO_THREADSAFE_SUPPORT) && !defined(IJHA_H32_NO_WAIT_SUPPORT) && (defined(_WIN32) || defined(__linux__))
+   #define IJHA_H32_HAS_WAIT (1)
+#endif
+
 struct ijha_h32;
 
 typedef unsigned ijha_h32_acquire_func(struct ijha_h32 *self, unsigned userflags, unsigned *handle_out);
@@ -169,6 +191,9 @@ struct ijha_h32 {
 
    unsigned size;
    unsigned capacity;
+   /* slots in [watermark, capacity) is considered free regardless of their
+    * content and is lazily threaded on acquire, see 'ijha_h32_invalidate_all' */
+   unsigned watermark;
 
    unsigned capacity_mask;
    unsigned generation_mask;
@@ -180,6 +205,11 @@ struct ijha_h32 {
    unsigned freelist_enqueue_index;
    /* dequeue/remove/get items from the front (FIFO) */
    unsigned freelist_dequeue_index;
+
+   /* number of threads blocked in 'ijha_h32_acquire_wait' */
+   unsigned num_waiters;
+   /* increased by release when there is waiters, the word that is waited on */
+   unsigned wait_serial;
 };
 
 /* max number of handles does _not_ have to be power of two.
@@ -205,7 +235,8 @@ enum ijha_h32_init_res {
    IJHA_H32_INIT_USERDATA_TOO_BIG = 1 << 2,
    IJHA_H32_INIT_HANDLE_OFFSET_TOO_BIG = 1 << 3, /* offset to handle is too big */
    IJHA_H32_INIT_HANDLE_NON_INLINE_SIZE_TOO_BIG = 1 << 4,
-   IJHA_H32_INIT_INVALID_INPUT_FLAGS = 1 << 5
+   IJHA_H32_INIT_INVALID_INPUT_FLAGS = 1 << 5,
+   IJHA_H32_INIT_MEMORY_OFFSET_INVALID = 1 << 6 /* 'ijha_h32_shared' only, memory is located before the instance */
 };
 
 enum ijha_h32_init_flags {
@@ -304,6 +335,21 @@ IJHA_H32_API int ijha_h32_initex(struct ijha_h32 *self, unsigned max_num_handles
 /* reset to initial state (as if no handles been used) */
 IJHA_H32_API void ijha_h32_reset(struct ijha_h32 *self);
 
+/* invalidates all handles in O(1), as opposed to 'ijha_h32_reset' which touches
+ * every slot. the slots is instead lazily (re-)threaded on subsequent acquires and
+ * the generation of each slot continues from where it was, so handles acquired
+ * before the invalidation stays invalid when the slot is reused.
+ *
+ * NB: unlike 'ijha_h32_reset' the sparse indices handed out after invalidation
+ *     is not guaranteed to match those of a newly initialized instance
+ *     (i.e. 'constant handles', see 'ijha_h32_test_constant_handles').
+ * NB: not thread-safe, even for IJHA_H32_INIT_THREADSAFE instances. it must be
+ *     externally synchronized with _all_ other use of the instance, including
+ *     'ijha_h32_valid'/'ijha_h32_userdata_checked', as the watermark and the
+ *     slots is read without ordering, so a stale handle checked concurrently
+ *     with the invalidation may pass as valid */
+IJHA_H32_API void ijha_h32_invalidate_all(struct ijha_h32 *self);
+
 #define ijha_h32_is_fifo(self) (((self)->flags_num_userflag_bits&IJHA_H32_INIT_FIFO)==IJHA_H32_INIT_FIFO)
 
 /* how many handles can be used */
@@ -360,11 +406,67 @@ IJHA_H32_API void ijha_h32_reset(struct ijha_h32 *self);
 #define ijha_h32_acquire_userflags(self, userflags, handle_out) ((self)->acquire_func)((self), (userflags), (handle_out))
 #define ijha_h32_acquire(self, handle_out) ijha_h32_acquire_userflags((self), 0, (handle_out))
 
+/* acquires 'num_handles' handles with consecutive sparse indices, i.e. the
+ * userdata of the handles is laid out contiguously in memory (with the stride
+ * of the instance). as the generation is per slot the handles is stored in the
+ * 'handles_out' array ('num_handles' entries), all with the same userflags.
+ *
+ * returns the index of the first handle on success, IJHA_H32_INVALID_INDEX if
+ * no run of free slots was found (handles_out[0] is then set to 0).
+ *
+ * slots that never been used since the last reset/invalidation is tried first
+ * (O(num_handles)), otherwise the slots is scanned for a run of free slots and
+ * the run is unlinked from the freelist (O(capacity)).
+ *
+ * NB: not supported for thread-safe instances (returns IJHA_H32_INVALID_INDEX) */
+IJHA_H32_API unsigned ijha_h32_acquire_range(struct ijha_h32 *self, unsigned num_handles, unsigned userflags, unsigned *handles_out);
+
+/* acquires a handle, like 'ijha_h32_acquire_userflags', but prefers a free slot
+ * close to 'hint_index' (ex. the index of a parent object) so related userdata
+ * is colocated in memory.
+ *
+ * only the first IJHA_H32_ACQUIRE_NEAR_MAX_PROBES nodes of the freelist, and the
+ * first slot that never been used since the last reset/invalidation, is
+ * considered so the cost is bounded. the closest of these, if within
+ * IJHA_H32_ACQUIRE_NEAR_WINDOW_BYTES of the hint, is used, otherwise it falls
+ * back to the normal acquire.
+ *
+ * NB: thread-safe instances always falls back to the normal acquire */
+IJHA_H32_API unsigned ijha_h32_acquire_near(struct ijha_h32 *self, unsigned hint_index, unsigned userflags, unsigned *handle_out);
+
+/* releases 'num_handles' handles stored in 'handles', ex. acquired with 'ijha_h32_acquire_range'.
+ * the handles is released in reverse order, so the freelist yields them in
+ * ascending index order again (if LIFO).
+ * returns the number of handles that was valid and released */
+IJHA_H32_API unsigned ijha_h32_release_range(struct ijha_h32 *self, unsigned num_handles, const unsigned *handles);
+
+#if IJHA_H32_HAS_WAIT
+
+#define IJHA_H32_WAIT_INFINITE ((ijha_h32_uint64)-1)
+
+/* acquires a handle, like 'ijha_h32_acquire_userflags', but if all handles is
+ * used the calling thread is blocked until a handle is released or 'timeout_ns'
+ * nanoseconds has passed (IJHA_H32_WAIT_INFINITE to wait forever, 0 to not wait).
+ *
+ * returns the index of the handle on success, IJHA_H32_INVALID_INDEX on timeout.
+ *
+ * release only wakes a waiter when there is threads waiting, so there is no
+ * cost (besides one load in release) if 'ijha_h32_acquire_wait' is not used.
+ *
+ * NB: only for thread-safe instances (IJHA_H32_INIT_THREADSAFE)
+ * NB: only available on Linux (futex) and Windows 8+ (WaitOnAddress, links
+ *     with Synchronization.lib), i.e. when IJHA_H32_HAS_WAIT is defined.
+ *     define IJHA_H32_NO_WAIT_SUPPORT to disable it */
+IJHA_H32_API unsigned ijha_h32_acquire_wait(struct ijha_h32 *self, unsigned userflags, unsigned *handle_out, ijha_h32_uint64 timeout_ns);
+
+#endif /* IJHA_H32_HAS_WAIT */
+
 /* index of the handle (stable, i.e. will not move) */
 #define ijha_h32_index(self, handle) ((self)->capacity_mask & (handle))
 
 /* if index or handle is in use
- * NB: 'ijha_h32_in_use' checks the passed in handle, _NOT_ the stored handle */
+ * NB: 'ijha_h32_in_use' checks the passed in handle, _NOT_ the stored handle
+ * NB: 'ijha_h32_in_use_index' is only valid for index below 'watermark' */
 #define ijha_h32_in_use_bit(self) ((self)->in_use_bit)
 #define ijha_h32_in_use(self, handle) ((handle)&ijha_h32_in_use_bit((self)))
 #define ijha_h32_in_use_index(self, index) ijha_h32_in_use((self), *ijha_h32_handle_info_at((self), (index)))
@@ -380,7 +482,7 @@ IJHA_H32_API void ijha_h32_reset(struct ijha_h32 *self);
 /* pointer to handle */
 #define ijha_h32_handle_info_at(self, index) ijha_h32_pointer_add(unsigned *, (self)->handles, ijha_h32_handle_offset((self)->handles_stride_userdata_offset) + ijha_h32_handle_stride((self)->handles_stride_userdata_offset) * (index))
 
-#define ijha_h32_valid_mask(self, handle, handlemask) (((self)->capacity > ((handle) & (self)->capacity_mask)) && ijha_h32_in_use((self), (handle)) && ((*ijha_h32_handle_info_at((self), ((handle) & (self)->capacity_mask)) & (handlemask)) == ((handle) & (handlemask))))
+#define ijha_h32_valid_mask(self, handle, handlemask) (((self)->watermark > ((handle) & (self)->capacity_mask)) && ijha_h32_in_use((self), (handle)) && ((*ijha_h32_handle_info_at((self), ((handle) & (self)->capacity_mask)) & (handlemask)) == ((handle) & (handlemask))))
 /* if handle is valid/active */
 #define ijha_h32_valid(self, handle) ijha_h32_valid_mask((self), (handle), (0xffffffffu))
 
@@ -414,6 +516,95 @@ IJHA_H32_API unsigned ijha_h32_userflags_set(struct ijha_h32 *self, unsigned han
  * returns the index of the handle if the handle was valid, IJHA_H32_INVALID_INDEX if invalid. */
 #define ijha_h32_release(self, handle) ((self)->release_func)((self), handle)
 
+/* position independent version of 'struct ijha_h32' that can be placed in memory
+ * shared between processes (shm_open/memfd/mapped files) which is mapped at
+ * different addresses in the different processes.
+ *
+ * no absolute pointers is stored, the handles (and _optional_ userdata) is
+ * located 'handles_offset' bytes from the start of the structure and the
+ * LIFO/FIFO/thread-safe dispatch is done on the flags instead of function pointers.
+ *
+ * if initialized with 'IJHA_H32_INIT_THREADSAFE' the lock-free LIFO is also
+ * process-safe (provided that the platform atomics is lock-free, which is the
+ * case for 32-bit CAS on all supported platforms) so handles can be acquired
+ * and released concurrently from multiple processes without any IPC.
+ *
+ * the field names is the same as in 'struct ijha_h32' so the macros that does not
+ * touch the handles works on both, i.e:
+ *    ijha_h32_capacity, ijha_h32_is_fifo, ijha_h32_index, ijha_h32_in_use,
+ *    ijha_h32_in_use_bit, ijha_h32_userflags_num_bits,
+ *    ijha_h32_userflags_to_handle(_bits), ijha_h32_userflags_from_handle(_bits)
+ *    and ijha_h32_memory_size_allocated
+ *
+ * ex: (error handling omitted)
+ *    process A:
+ *       unsigned size = sizeof(struct ijha_h32_shared) + ijha_h32_memory_size_needed(max_num_handles, 0, 0);
+ *       int fd = shm_open("/handles", O_CREAT|O_RDWR, 0600);
+ *       ftruncate(fd, size);
+ *       struct ijha_h32_shared *self = mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+ *       ijha_h32_shared_init_no_inlinehandles(self, max_num_handles, 0, 0, IJHA_H32_INIT_THREADSAFE, self+1);
+ *    process B:
+ *       int fd = shm_open("/handles", O_RDWR, 0600);
+ *       struct ijha_h32_shared *self = mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+ *       ijha_h32_shared_acquire(self, &handle);
+ */
+struct ijha_h32_shared {
+   /* byte offset from the start of this structure to the handles */
+   unsigned handles_offset;
+
+   unsigned flags_num_userflag_bits;
+   unsigned handles_stride_userdata_offset;
+
+   unsigned size;
+   unsigned capacity;
+
+   unsigned capacity_mask;
+   unsigned generation_mask;
+   unsigned userflags_mask;
+
+   unsigned in_use_bit;
+
+   unsigned freelist_enqueue_index;
+   unsigned freelist_dequeue_index;
+};
+
+/* same as 'ijha_h32_initex' but memory must be located after self, in the same
+ * mapping, as the offset between the two is what is stored. the memory that is
+ * needed is calculated in the same way, use 'ijha_h32_memory_size_needed'
+ *
+ * returns IJHA_H32_INIT_MEMORY_OFFSET_INVALID (ORed) if memory is located before,
+ * or overlaps, self
+ *
+ * NB: initialization is not process-safe, it must be done by one process before
+ *     the memory is used by others */
+IJHA_H32_API int ijha_h32_shared_initex(struct ijha_h32_shared *self, unsigned max_num_handles, unsigned num_userflag_bits, unsigned non_inline_handle_size_bytes, unsigned handle_offset, unsigned userdata_size_in_bytes_per_item, unsigned ijha_flags, void *memory);
+
+#define ijha_h32_shared_init_no_inlinehandles(self, max_num_handles, num_userflag_bits, userdata_size_in_bytes_per_item, ijha_flags, memory) ijha_h32_shared_initex((self), (max_num_handles), (num_userflag_bits), sizeof(unsigned), 0, (userdata_size_in_bytes_per_item), (ijha_flags), (void*)(memory))
+#define ijha_h32_shared_init_inlinehandles(self, max_num_handles, num_userflag_bits, userdata_size_in_bytes_per_item, byte_offset_to_handle, ijha_flags, memory) ijha_h32_shared_initex((self), (max_num_handles), (num_userflag_bits), 0, (byte_offset_to_handle), (userdata_size_in_bytes_per_item), (ijha_flags), (memory))
+
+/* reset to initial state (as if no handles been used)
+ * NB: not process-safe */
+IJHA_H32_API void ijha_h32_shared_reset(struct ijha_h32_shared *self);
+
+/* see 'ijha_h32_acquire_userflags' */
+IJHA_H32_API unsigned ijha_h32_shared_acquire_userflags(struct ijha_h32_shared *self, unsigned userflags, unsigned *handle_out);
+#define ijha_h32_shared_acquire(self, handle_out) ijha_h32_shared_acquire_userflags((self), 0, (handle_out))
+
+/* see 'ijha_h32_release' */
+IJHA_H32_API unsigned ijha_h32_shared_release(struct ijha_h32_shared *self, unsigned handle);
+
+/* see 'ijha_h32_userflags_set' */
+IJHA_H32_API unsigned ijha_h32_shared_userflags_set(struct ijha_h32_shared *self, unsigned handle, unsigned userflags);
+
+#define ijha_h32_shared_handles(self) ijha_h32_pointer_add(void *, (self), (self)->handles_offset)
+#define ijha_h32_shared_handle_info_at(self, index) ijha_h32_pointer_add(unsigned *, ijha_h32_shared_handles((self)), ijha_h32_handle_offset((self)->handles_stride_userdata_offset) + ijha_h32_handle_stride((self)->handles_stride_userdata_offset) * (index))
+#define ijha_h32_shared_in_use_index(self, index) ijha_h32_in_use((self), *ijha_h32_shared_handle_info_at((self), (index)))
+#define ijha_h32_shared_valid_mask(self, handle, handlemask) (((self)->capacity > ((handle) & (self)->capacity_mask)) && ijha_h32_in_use((self), (handle)) && ((*ijha_h32_shared_handle_info_at((self), ((handle) & (self)->capacity_mask)) & (handlemask)) == ((handle) & (handlemask))))
+#define ijha_h32_shared_valid(self, handle) ijha_h32_shared_valid_mask((self), (handle), (0xffffffffu))
+#define ijha_h32_shared_userflags(self, handle_or_index) (*ijha_h32_shared_handle_info_at((self), ijha_h32_index((self), (handle_or_index)))&((self)->userflags_mask))
+#define ijha_h32_shared_userdata(userdata_type, self, handle_or_index) ijha_h32_pointer_add(userdata_type, ijha_h32_shared_handles((self)), ijha_h32_handle_stride((self)->handles_stride_userdata_offset) * (ijha_h32_index((self), (handle_or_index))) + ijha_h32_userdata_offset((self)->handles_stride_userdata_offset))
+#define ijha_h32_shared_userdata_checked(userdata_type, self, handle) (ijha_h32_shared_valid(self, handle) ? ijha_h32_shared_userdata(userdata_type, self, handle) : 0)
+
 #ifdef __cplusplus
    }
 #endif
@@ -463,6 +654,38 @@ IJHA_H32_API unsigned ijha_h32_userflags_set(struct ijha_h32 *self, unsigned han
 
       #define IJHA_H32_HAS_ATOMICS (1)
    #endif
+
+   #if IJHA_H32_HAS_WAIT
+      #if _WIN32
+         #include <stddef.h>
+
+         IJHA_H32__EXTERNC_DECL_BEGIN
+            __declspec(dllimport) int __stdcall WaitOnAddress(volatile void *Address, void *CompareAddress, size_t AddressSize, unsigned long dwMilliseconds);
+            __declspec(dllimport) void __stdcall WakeByAddressSingle(void *Address);
+            __declspec(dllimport) unsigned __int64 __stdcall GetTickCount64(void);
+         IJHA_H32__EXTERNC_DECL_END
+
+         #pragma comment(lib, "Synchronization.lib")
+      #else
+         #include <unistd.h>
+         #include <sys/syscall.h>
+
+         #ifndef __cplusplus
+            /* not declared by unistd.h in strict ANSI-modes */
+            long syscall(long number, ...);
+         #endif
+
+         /* the (old) kernel timespec used by __NR_futex and __NR_clock_gettime */
+         struct ijha_h32__timespec {
+            long tv_sec;
+            long tv_nsec;
+         };
+
+         #define IJHA_H32__FUTEX_WAKE_PRIVATE (1 | 128)
+         #define IJHA_H32__FUTEX_WAIT_BITSET_PRIVATE (9 | 128)
+         #define IJHA_H32__CLOCK_MONOTONIC (1)
+      #endif
+   #endif /* IJHA_H32_HAS_WAIT */
 #endif /* ifndef IJHA_H32_NO_THREADSAFE_SUPPORT */
 
 #ifndef IJHA_H32_assert
@@ -470,6 +693,16 @@ IJHA_H32_API unsigned ijha_h32_userflags_set(struct ijha_h32 *self, unsigned han
    #define IJHA_H32_assert assert
 #endif
 
+/* how many freelist nodes 'ijha_h32_acquire_near' inspects */
+#ifndef IJHA_H32_ACQUIRE_NEAR_MAX_PROBES
+   #define IJHA_H32_ACQUIRE_NEAR_MAX_PROBES (16)
+#endif
+
+/* how far away, in bytes, a slot may be from the hint in 'ijha_h32_acquire_near' */
+#ifndef IJHA_H32_ACQUIRE_NEAR_WINDOW_BYTES
+   #define IJHA_H32_ACQUIRE_NEAR_WINDOW_BYTES (4096)
+#endif
+
 /* handle the runtime-option where the "in use"-bit is stored.
  *    - "in use"-bit is stored in MSB     -> (capacity_mask+1) is the first generation bit
  *    or
@@ -497,20 +730,36 @@ static unsigned ijha_h32__acquire_userflags_lifo_fifo(struct ijha_h32 *self, uns
       *handle_out = 0;
       return IJHA_H32_INVALID_INDEX;
    } else {
-      unsigned *handle = ijha_h32_handle_info_at(self, current_cursor);
-      unsigned current_handle = *handle;
+      unsigned *handle;
+      unsigned current_handle;
       unsigned generation_mask = self->generation_mask;
       unsigned generation_to_add = ijha_h32__generation_add(self);
+      unsigned new_generation, new_handle;
+
+      /* slots above the watermark is free but not yet threaded into the freelist
+       * (see 'ijha_h32_invalidate_all'). LIFO prefers the already threaded (hot)
+       * slots while FIFO prefers the untouched slots as it delays the reuse */
+      if (ijha_h32_is_fifo(self) ? (self->watermark < maxnhandles) : (self->watermark == self->size)) {
+         current_cursor = self->watermark++;
+         /* FIFO: last slot is already threaded as the enqueue node */
+         if (self->watermark == maxnhandles)
+            self->watermark = self->capacity;
+
+         handle = ijha_h32_handle_info_at(self, current_cursor);
+         current_handle = *handle;
+      } else {
+         handle = ijha_h32_handle_info_at(self, current_cursor);
+         current_handle = *handle;
+         self->freelist_dequeue_index = current_handle & self->capacity_mask;
+      }
 
-      unsigned new_cursor = current_handle & self->capacity_mask;
-      unsigned new_generation = generation_mask & (current_handle + generation_to_add);
-      unsigned new_handle = userflags | new_generation | in_use_bit | current_cursor;
+      new_generation = generation_mask & (current_handle + generation_to_add);
+      new_handle = userflags | new_generation | in_use_bit | current_cursor;
 
       IJHA_H32_assert(!generation_mask || (*handle & generation_mask) != new_generation); /* no generation or has changed generation */
 
       *handle = *handle_out = new_handle;
 
-      self->freelist_dequeue_index = new_cursor;
       ++self->size;
       return current_cursor;
    }
@@ -538,8 +787,33 @@ static unsigned ijha_h32__acquire_lifo_ts(struct ijha_h32 *self, unsigned userfl
 
       /* first slot is used as a sentinel/end-of-list */
       if (current_index == 0) {
-         *handle_out = 0;
-         return IJHA_H32_INVALID_INDEX;
+         /* freelist is empty, try the slots that is not yet threaded (see 'ijha_h32_invalidate_all') */
+         unsigned watermark = self->watermark;
+         if (watermark == self->capacity) {
+            *handle_out = 0;
+            return IJHA_H32_INVALID_INDEX;
+         }
+
+         if (IJHA_H32_CAS(&self->watermark, watermark + 1, watermark)) {
+            unsigned new_generation, new_handle;
+            handle = ijha_h32_handle_info_at(self, watermark);
+            current_handle = *handle;
+            new_generation = generation_mask & (current_handle + handle_generation_add);
+            new_handle = userflags | new_generation | in_use_bit | watermark;
+
+            IJHA_H32_assert(!generation_mask || (current_handle & generation_mask) != new_generation); /* no generation or has changed generation */
+
+            /* the slot still holds its handle from before the invalidate, a stale
+             * release of it now passes the watermark check. publish with a CAS so
+             * only one of them gets the slot, if the release won it is on the freelist */
+            if (!IJHA_H32_CAS(handle, new_handle, current_handle))
+               continue;
+            *handle_out = new_handle;
+            IJHA_H32_InterlockedIncrement(&self->size);
+
+            return watermark;
+         }
+         continue;
       }
 
       next_freelist_index = current_handle&capacity_mask;
@@ -567,7 +841,7 @@ static unsigned ijha_h32__release_fifo(struct ijha_h32 *self, unsigned handle)
 {
    unsigned in_use_bit = ijha_h32_in_use_bit(self);
    unsigned idx = handle & self->capacity_mask;
-   unsigned *stored_handle = ((self->capacity > idx) && (handle & in_use_bit)) ? ijha_h32_handle_info_at(self, idx) : 0;
+   unsigned *stored_handle = ((self->watermark > idx) && (handle & in_use_bit)) ? ijha_h32_handle_info_at(self, idx) : 0;
 
    if (stored_handle && *stored_handle == handle) {
       /* clear in_use-bit of current */
@@ -589,7 +863,7 @@ static unsigned ijha_h32__release_lifo(struct ijha_h32 *self, unsigned handle)
 {
    unsigned in_use_bit = ijha_h32_in_use_bit(self);
    unsigned idx = handle & self->capacity_mask;
-   unsigned *stored_handle = ((self->capacity > idx) && (handle & in_use_bit)) ? ijha_h32_handle_info_at(self, idx) : 0;
+   unsigned *stored_handle = ((self->watermark > idx) && (handle & in_use_bit)) ? ijha_h32_handle_info_at(self, idx) : 0;
 
    if (stored_handle && *stored_handle == handle) {
       unsigned current_cursor = self->freelist_dequeue_index;
@@ -606,36 +880,111 @@ static unsigned ijha_h32__release_lifo(struct ijha_h32 *self, unsigned handle)
 
 #if IJHA_H32_HAS_ATOMICS
 
+#if IJHA_H32_HAS_WAIT
+
+#if _WIN32
+
+static ijha_h32_uint64 ijha_h32__now_ns(void)
+{
+   return GetTickCount64() * 1000000;
+}
+
+/* returns 0 if the deadline has passed */
+static int ijha_h32__wait(struct ijha_h32 *self, unsigned serial, ijha_h32_uint64 deadline_ns)
+{
+   unsigned long ms = 0xffffffff; /* INFINITE */
+   if (deadline_ns != IJHA_H32_WAIT_INFINITE) {
+      ijha_h32_uint64 now = ijha_h32__now_ns();
+      if (now >= deadline_ns)
+         return 0;
+      ms = (unsigned long)((deadline_ns - now + 999999) / 1000000);
+   }
+   WaitOnAddress(&self->wait_serial, &serial, sizeof serial, ms);
+   return deadline_ns == IJHA_H32_WAIT_INFINITE || ijha_h32__now_ns() < deadline_ns;
+}
+
+static void ijha_h32__wake(struct ijha_h32 *self)
+{
+   IJHA_H32_InterlockedIncrement(&self->wait_serial);
+   WakeByAddressSingle(&self->wait_serial);
+}
+
+#else
+
+static ijha_h32_uint64 ijha_h32__now_ns(void)
+{
+   struct ijha_h32__timespec ts;
+   syscall(__NR_clock_gettime, IJHA_H32__CLOCK_MONOTONIC, &ts);
+   return (ijha_h32_uint64)ts.tv_sec * 1000000000 + (ijha_h32_uint64)ts.tv_nsec;
+}
+
+/* returns 0 if the deadline has passed */
+static int ijha_h32__wait(struct ijha_h32 *self, unsigned serial, ijha_h32_uint64 deadline_ns)
+{
+   struct ijha_h32__timespec deadline;
+   if (deadline_ns == IJHA_H32_WAIT_INFINITE) {
+      syscall(__NR_futex, &self->wait_serial, IJHA_H32__FUTEX_WAIT_BITSET_PRIVATE, serial, (void*)0, (void*)0, 0xffffffffu);
+      return 1;
+   }
+
+   /* absolute CLOCK_MONOTONIC timeout, so spurious wakeups does not extend the wait */
+   deadline.tv_sec = (long)(deadline_ns / 1000000000);
+   deadline.tv_nsec = (long)(deadline_ns % 1000000000);
+   syscall(__NR_futex, &self->wait_serial, IJHA_H32__FUTEX_WAIT_BITSET_PRIVATE, serial, &deadline, (void*)0, 0xffffffffu);
+   return ijha_h32__now_ns() < deadline_ns;
+}
+
+static void ijha_h32__wake(struct ijha_h32 *self)
+{
+   IJHA_H32_InterlockedIncrement(&self->wait_serial);
+   syscall(__NR_futex, &self->wait_serial, IJHA_H32__FUTEX_WAKE_PRIVATE, 1, (void*)0, (void*)0, 0);
+}
+
+#endif
+
+#endif /* IJHA_H32_HAS_WAIT */
+
 static unsigned ijha_h32__release_lifo_ts(struct ijha_h32 *self, unsigned handle)
 {
    unsigned *current_freelist_index_serial = &self->freelist_dequeue_index;
    unsigned capacity_mask = self->capacity_mask;
    unsigned in_use_bit = ijha_h32_in_use_bit(self);
    unsigned idx = handle & capacity_mask;
-   unsigned *stored_handle = ((self->capacity > idx) && (handle & in_use_bit)) ? ijha_h32_handle_info_at(self, idx) : 0;
+   unsigned *stored_handle = ((self->watermark > idx) && (handle & in_use_bit)) ? ijha_h32_handle_info_at(self, idx) : 0;
 
-   if (stored_handle && *stored_handle == handle) {
+   if (stored_handle) {
       unsigned freelist_serial_add = capacity_mask + 1;
       /* clear in_use_bit and index */
-      handle &= ~(capacity_mask | in_use_bit);
+      unsigned released_handle = handle & ~(capacity_mask | in_use_bit);
+      unsigned old_freelist_index_serial = *current_freelist_index_serial;
+
+      /* take the slot with a CAS, of racing releases of the same handle (or an
+       * acquire of a slot past the watermark, see above) only one succeeds */
+      if (!IJHA_H32_CAS(stored_handle, released_handle | (old_freelist_index_serial&capacity_mask), handle))
+         return IJHA_H32_INVALID_INDEX;
 
       for (;;) {
-         unsigned old_freelist_index_serial = *current_freelist_index_serial;
          /* increase serial and change the freelist index to that of the released handle */
          unsigned new_freelist_index_serial = ((old_freelist_index_serial + freelist_serial_add)&~capacity_mask) | idx;
 
          IJHA_H32_assert((old_freelist_index_serial&~capacity_mask) != (new_freelist_index_serial&~capacity_mask));
 
-         /* store current freelist index at the place of the release handle */
-         *stored_handle = handle | (old_freelist_index_serial&capacity_mask);
-
          /* try to redirect freelist to current index */
          if (IJHA_H32_CAS(current_freelist_index_serial, new_freelist_index_serial, old_freelist_index_serial))
             break;
+
+         /* store current freelist index at the place of the release handle */
+         old_freelist_index_serial = *current_freelist_index_serial;
+         *stored_handle = released_handle | (old_freelist_index_serial&capacity_mask);
       }
 
       IJHA_H32_InterlockedDecrement(&self->size);
 
+#if IJHA_H32_HAS_WAIT
+      if (self->num_waiters)
+         ijha_h32__wake(self);
+#endif
+
       return idx;
    }
 
@@ -679,6 +1028,8 @@ IJHA_H32_API int ijha_h32_initex(struct ijha_h32 *self, unsigned max_num_handles
 
    self->size = 0;
    self->capacity = max_num_handles;
+   self->num_waiters = 0;
+   self->wait_serial = 0;
    ijha_h32__roundup(max_num_handles);
    self->capacity_mask = max_num_handles - 1;
 
@@ -755,6 +1106,7 @@ IJHA_H32_API void ijha_h32_reset(struct ijha_h32 *self)
     */
    unsigned i, generation_mask = self->generation_mask;
    self->size = 0;
+   self->watermark = self->capacity;
 
    self->freelist_dequeue_index = 0;
    self->freelist_enqueue_index = self->capacity - 1;
@@ -771,6 +1123,206 @@ IJHA_H32_API void ijha_h32_reset(struct ijha_h32 *self)
       self->freelist_dequeue_index = 1; /* use the first slot as a sentinel/end-of-list */
 }
 
+IJHA_H32_API void ijha_h32_invalidate_all(struct ijha_h32 *self)
+{
+   /* the slot that is kept threaded (sentinel/enqueue node) must not be in use */
+   unsigned threaded_index = ijha_h32_is_fifo(self) ? self->capacity - 1 : 0;
+   unsigned *threaded = ijha_h32_handle_info_at(self, threaded_index);
+   *threaded &= ~ijha_h32_in_use_bit(self);
+
+   self->size = 0;
+
+   if (self->flags_num_userflag_bits & IJHA_H32_INIT_THREADSAFE) {
+      /* slot 0 is the sentinel/end-of-list, keep the serial increasing */
+      self->watermark = 1;
+      self->freelist_dequeue_index = (self->freelist_dequeue_index + self->capacity_mask + 1) & ~self->capacity_mask;
+   } else if (ijha_h32_is_fifo(self)) {
+      /* the last slot is the (empty) queue */
+      self->watermark = threaded_index ? 0 : self->capacity;
+      self->freelist_dequeue_index = self->freelist_enqueue_index = threaded_index;
+   } else {
+      self->watermark = 0;
+      self->freelist_dequeue_index = 0;
+   }
+}
+
+#if IJHA_H32_HAS_WAIT
+
+IJHA_H32_API unsigned ijha_h32_acquire_wait(struct ijha_h32 *self, unsigned userflags, unsigned *handle_out, ijha_h32_uint64 timeout_ns)
+{
+   ijha_h32_uint64 deadline_ns = IJHA_H32_WAIT_INFINITE;
+   unsigned idx;
+
+   IJHA_H32_assert(self->flags_num_userflag_bits & IJHA_H32_INIT_THREADSAFE);
+
+   idx = ijha_h32_acquire_userflags(self, userflags, handle_out);
+   if (idx != IJHA_H32_INVALID_INDEX || timeout_ns == 0)
+      return idx;
+
+   if (timeout_ns != IJHA_H32_WAIT_INFINITE)
+      deadline_ns = ijha_h32__now_ns() + timeout_ns;
+
+   for (;;) {
+      int timed_out = 0;
+      unsigned serial;
+
+      /* register as waiter _before_ the last attempt, a release that happens
+       * after the attempt will then see the waiter and change the serial */
+      IJHA_H32_InterlockedIncrement(&self->num_waiters);
+      serial = self->wait_serial;
+      idx = ijha_h32_acquire_userflags(self, userflags, handle_out);
+      if (idx == IJHA_H32_INVALID_INDEX)
+         timed_out = !ijha_h32__wait(self, serial, deadline_ns);
+      IJHA_H32_InterlockedDecrement(&self->num_waiters);
+
+      if (idx != IJHA_H32_INVALID_INDEX)
+         return idx;
+      /* a wake might been 'consumed' by us, so try once more before giving up */
+      if (timed_out)
+         return ijha_h32_acquire_userflags(self, userflags, handle_out);
+   }
+}
+
+#endif /* IJHA_H32_HAS_WAIT */
+
+/* number of nodes in the freelist (LIFO) or queue (FIFO, including the enqueue node) */
+static unsigned ijha_h32__num_threaded_free(struct ijha_h32 *self)
+{
+   return self->watermark - self->size + (ijha_h32_is_fifo(self) && self->watermark != self->capacity);
+}
+
+IJHA_H32_API unsigned ijha_h32_acquire_range(struct ijha_h32 *self, unsigned num_handles, unsigned userflags, unsigned *handles_out)
+{
+   unsigned i, first = IJHA_H32_INVALID_INDEX;
+   unsigned in_use_bit = ijha_h32_in_use_bit(self);
+   unsigned capacity_mask = self->capacity_mask;
+   unsigned generation_mask = self->generation_mask;
+   unsigned generation_to_add = ijha_h32__generation_add(self);
+   unsigned maxnhandles = self->capacity - ijha_h32_is_fifo(self);
+   int fifo = ijha_h32_is_fifo(self);
+
+   IJHA_H32_assert(num_handles > 0);
+   IJHA_H32_assert((self->userflags_mask & userflags) == userflags);
+
+   *handles_out = 0;
+   if ((self->flags_num_userflag_bits & IJHA_H32_INIT_THREADSAFE) || num_handles > maxnhandles - self->size)
+      return IJHA_H32_INVALID_INDEX;
+
+   if (self->watermark < maxnhandles && maxnhandles - self->watermark >= num_handles) {
+      /* fast path, take the slots that is not yet threaded */
+      first = self->watermark;
+   } else {
+      /* find a run of free slots, NB: the FIFO enqueue node is never free */
+      unsigned run = 0;
+      for (i = 0; i != self->capacity && run != num_handles; ++i) {
+         int is_free = i >= self->watermark || !(*ijha_h32_handle_info_at(self, i) & in_use_bit);
+         if (fifo && i == self->freelist_enqueue_index)
+            is_free = 0;
+         run = is_free ? run + 1 : 0;
+      }
+      if (run != num_handles)
+         return IJHA_H32_INVALID_INDEX;
+      first = i - num_handles;
+
+      /* unlink the threaded part of the run from the freelist/queue. NB: this
+       * is done even if the run starts at/above the watermark, as the FIFO
+       * last slot is queued regardless of the watermark */
+      {
+         unsigned *link = &self->freelist_dequeue_index;
+         unsigned cursor = self->freelist_dequeue_index;
+         unsigned n = ijha_h32__num_threaded_free(self);
+         for (i = 0; i != n; ++i) {
+            unsigned *node = ijha_h32_handle_info_at(self, cursor);
+            unsigned next = *node & capacity_mask;
+            if (cursor - first < num_handles)
+               *link = (*link & ~capacity_mask) | next;
+            else
+               link = node;
+            cursor = next;
+         }
+      }
+   }
+
+   if (first + num_handles > self->watermark)
+      self->watermark = first + num_handles == maxnhandles ? self->capacity : first + num_handles;
+
+   for (i = 0; i != num_handles; ++i) {
+      unsigned *handle = ijha_h32_handle_info_at(self, first + i);
+      unsigned new_generation = generation_mask & (*handle + generation_to_add);
+      IJHA_H32_assert(!generation_mask || (*handle & generation_mask) != new_generation); /* no generation or has changed generation */
+      *handle = handles_out[i] = userflags | new_generation | in_use_bit | (first + i);
+   }
+
+   self->size += num_handles;
+   return first;
+}
+
+IJHA_H32_API unsigned ijha_h32_acquire_near(struct ijha_h32 *self, unsigned hint_index, unsigned userflags, unsigned *handle_out)
+{
+   unsigned i, n, cursor, *link, *handle, new_generation;
+   unsigned capacity_mask = self->capacity_mask;
+   unsigned maxnhandles = self->capacity - ijha_h32_is_fifo(self);
+   unsigned window = IJHA_H32_ACQUIRE_NEAR_WINDOW_BYTES / ijha_h32_handle_stride(self->handles_stride_userdata_offset);
+   unsigned best = IJHA_H32_INVALID_INDEX, best_distance = window + 1, *best_link = 0;
+
+   IJHA_H32_assert((self->userflags_mask & userflags) == userflags);
+
+   if ((self->flags_num_userflag_bits & IJHA_H32_INIT_THREADSAFE) || self->size == maxnhandles)
+      return ijha_h32_acquire_userflags(self, userflags, handle_out);
+
+   /* the first slot that is not yet threaded */
+   if (self->watermark < maxnhandles) {
+      best = self->watermark;
+      best_distance = best > hint_index ? best - hint_index : hint_index - best;
+   }
+
+   /* NB: the FIFO enqueue node must stay in the queue */
+   n = ijha_h32__num_threaded_free(self) - ijha_h32_is_fifo(self);
+   if (n > IJHA_H32_ACQUIRE_NEAR_MAX_PROBES)
+      n = IJHA_H32_ACQUIRE_NEAR_MAX_PROBES;
+
+   link = &self->freelist_dequeue_index;
+   cursor = self->freelist_dequeue_index;
+   for (i = 0; i != n; ++i) {
+      unsigned *node = ijha_h32_handle_info_at(self, cursor);
+      unsigned distance = cursor > hint_index ? cursor - hint_index : hint_index - cursor;
+      /* FIFO: the last slot is queued but is above the watermark after
+       * 'ijha_h32_invalidate_all', it is left to the plain acquire */
+      if (distance < best_distance && cursor < self->watermark) {
+         best = cursor;
+         best_distance = distance;
+         best_link = link;
+      }
+      link = node;
+      cursor = *node & capacity_mask;
+   }
+
+   if (best_distance > window)
+      return ijha_h32_acquire_userflags(self, userflags, handle_out);
+
+   handle = ijha_h32_handle_info_at(self, best);
+   if (best_link) {
+      /* unlink from the freelist/queue */
+      *best_link = (*best_link & ~capacity_mask) | (*handle & capacity_mask);
+   } else {
+      self->watermark = best + 1 == maxnhandles ? self->capacity : best + 1;
+   }
+
+   new_generation = self->generation_mask & (*handle + ijha_h32__generation_add(self));
+   IJHA_H32_assert(!self->generation_mask || (*handle & self->generation_mask) != new_generation); /* no generation or has changed generation */
+   *handle = *handle_out = userflags | new_generation | ijha_h32_in_use_bit(self) | best;
+   ++self->size;
+   return best;
+}
+
+IJHA_H32_API unsigned ijha_h32_release_range(struct ijha_h32 *self, unsigned num_handles, const unsigned *handles)
+{
+   unsigned num_released = 0;
+   while (num_handles--)
+      num_released += ijha_h32_release(self, handles[num_handles]) != IJHA_H32_INVALID_INDEX;
+   return num_released;
+}
+
 IJHA_H32_API unsigned ijha_h32_userflags_set(struct ijha_h32 *self, unsigned handle, unsigned userflags)
 {
    unsigned ohandle, *p;
@@ -782,6 +1334,206 @@ IJHA_H32_API unsigned ijha_h32_userflags_set(struct ijha_h32 *self, unsigned han
    return ohandle & self->userflags_mask;
 }
 
+/* creates a (process local) 'struct ijha_h32' from the position independent one,
+ * NB: only the non-atomic parts of the API may be used on the view */
+static void ijha_h32_shared__view(struct ijha_h32_shared *self, struct ijha_h32 *view)
+{
+   view->handles = ijha_h32_shared_handles(self);
+   view->acquire_func = 0;
+   view->release_func = 0;
+   view->flags_num_userflag_bits = self->flags_num_userflag_bits;
+   view->handles_stride_userdata_offset = self->handles_stride_userdata_offset;
+   view->size = self->size;
+   view->capacity = self->capacity;
+   view->watermark = self->capacity;
+   view->capacity_mask = self->capacity_mask;
+   view->generation_mask = self->generation_mask;
+   view->userflags_mask = self->userflags_mask;
+   view->in_use_bit = self->in_use_bit;
+   view->freelist_enqueue_index = self->freelist_enqueue_index;
+   view->freelist_dequeue_index = self->freelist_dequeue_index;
+   view->num_waiters = 0;
+   view->wait_serial = 0;
+}
+
+IJHA_H32_API int ijha_h32_shared_initex(struct ijha_h32_shared *self, unsigned max_num_handles, unsigned num_userflag_bits, unsigned non_inline_handle_size_bytes, unsigned handle_offset, unsigned userdata_size_in_bytes_per_item, unsigned ijha_flags, void *memory)
+{
+   struct ijha_h32 view;
+   int init_res;
+
+   if ((unsigned char*)memory < (unsigned char*)(self + 1) || (unsigned char*)memory - (unsigned char*)self > 0xffffffffu)
+      return IJHA_H32_INIT_MEMORY_OFFSET_INVALID;
+
+   init_res = ijha_h32_initex(&view, max_num_handles, num_userflag_bits, non_inline_handle_size_bytes, handle_offset, userdata_size_in_bytes_per_item, ijha_flags, memory);
+
+   self->handles_offset = (unsigned)((unsigned char*)memory - (unsigned char*)self);
+   self->flags_num_userflag_bits = view.flags_num_userflag_bits;
+   self->handles_stride_userdata_offset = view.handles_stride_userdata_offset;
+   self->size = view.size;
+   self->capacity = view.capacity;
+   self->capacity_mask = view.capacity_mask;
+   self->generation_mask = view.generation_mask;
+   self->userflags_mask = view.userflags_mask;
+   self->in_use_bit = view.in_use_bit;
+   self->freelist_enqueue_index = view.freelist_enqueue_index;
+   self->freelist_dequeue_index = view.freelist_dequeue_index;
+
+   return init_res;
+}
+
+IJHA_H32_API void ijha_h32_shared_reset(struct ijha_h32_shared *self)
+{
+   struct ijha_h32 view;
+   ijha_h32_shared__view(self, &view);
+   ijha_h32_reset(&view);
+
+   self->size = view.size;
+   self->freelist_enqueue_index = view.freelist_enqueue_index;
+   self->freelist_dequeue_index = view.freelist_dequeue_index;
+}
+
+#if IJHA_H32_HAS_ATOMICS
+
+static unsigned ijha_h32_shared__acquire_lifo_ts(struct ijha_h32_shared *self, unsigned userflags, unsigned *handle_out)
+{
+   unsigned *current_freelist_index_serial = &self->freelist_dequeue_index;
+   unsigned generation_mask = self->generation_mask;
+   unsigned capacity_mask = self->capacity_mask;
+   unsigned freelist_serial_add = capacity_mask+1;
+   unsigned in_use_bit = ijha_h32_in_use_bit(self);
+   unsigned handle_generation_add = ijha_h32__generation_add(self);
+
+   for (;;) {
+      unsigned next_freelist_index;
+      unsigned new_freelist_index_serial;
+      unsigned old_freelist_index_serial = *current_freelist_index_serial;
+      unsigned current_index = old_freelist_index_serial&capacity_mask;
+      unsigned *handle = ijha_h32_shared_handle_info_at(self, current_index), current_handle = *handle;
+
+      /* first slot is used as a sentinel/end-of-list */
+      if (current_index == 0) {
+         *handle_out = 0;
+         return IJHA_H32_INVALID_INDEX;
+      }
+
+      next_freelist_index = current_handle&capacity_mask;
+      new_freelist_index_serial = ((old_freelist_index_serial + freelist_serial_add)&~capacity_mask) | next_freelist_index;
+      IJHA_H32_assert((old_freelist_index_serial&~capacity_mask) != (new_freelist_index_serial&~capacity_mask));
+
+      if (IJHA_H32_CAS(current_freelist_index_serial, new_freelist_index_serial, old_freelist_index_serial)) {
+         unsigned new_generation = generation_mask & (current_handle + handle_generation_add);
+         unsigned new_handle = userflags | new_generation | in_use_bit | current_index;
+
+         IJHA_H32_assert(!generation_mask || (current_handle & generation_mask) != new_generation); /* no generation or has changed generation */
+
+         *handle = *handle_out = new_handle;
+         IJHA_H32_InterlockedIncrement(&self->size);
+
+         return current_index;
+      }
+   }
+}
+
+static unsigned ijha_h32_shared__release_lifo_ts(struct ijha_h32_shared *self, unsigned handle, unsigned *stored_handle)
+{
+   unsigned *current_freelist_index_serial = &self->freelist_dequeue_index;
+   unsigned capacity_mask = self->capacity_mask;
+   unsigned freelist_serial_add = capacity_mask + 1;
+   unsigned idx = handle & capacity_mask;
+
+   /* clear in_use_bit and index */
+   handle &= ~(capacity_mask | ijha_h32_in_use_bit(self));
+
+   for (;;) {
+      unsigned old_freelist_index_serial = *current_freelist_index_serial;
+      unsigned new_freelist_index_serial = ((old_freelist_index_serial + freelist_serial_add)&~capacity_mask) | idx;
+
+      IJHA_H32_assert((old_freelist_index_serial&~capacity_mask) != (new_freelist_index_serial&~capacity_mask));
+
+      *stored_handle = handle | (old_freelist_index_serial&capacity_mask);
+
+      if (IJHA_H32_CAS(current_freelist_index_serial, new_freelist_index_serial, old_freelist_index_serial))
+         break;
+   }
+
+   IJHA_H32_InterlockedDecrement(&self->size);
+   return idx;
+}
+
+#endif /* IJHA_H32_HAS_ATOMICS */
+
+IJHA_H32_API unsigned ijha_h32_shared_acquire_userflags(struct ijha_h32_shared *self, unsigned userflags, unsigned *handle_out)
+{
+   IJHA_H32_assert((self->userflags_mask & userflags) == userflags);
+
+#if IJHA_H32_HAS_ATOMICS
+   if (self->flags_num_userflag_bits & IJHA_H32_INIT_THREADSAFE)
+      return ijha_h32_shared__acquire_lifo_ts(self, userflags, handle_out);
+#endif
+
+   if (self->size == self->capacity - ijha_h32_is_fifo(self)) {
+      *handle_out = 0;
+      return IJHA_H32_INVALID_INDEX;
+   } else {
+      unsigned current_cursor = self->freelist_dequeue_index;
+      unsigned *handle = ijha_h32_shared_handle_info_at(self, current_cursor);
+      unsigned current_handle = *handle;
+      unsigned new_generation = self->generation_mask & (current_handle + ijha_h32__generation_add(self));
+
+      IJHA_H32_assert(!self->generation_mask || (current_handle & self->generation_mask) != new_generation); /* no generation or has changed generation */
+
+      *handle = *handle_out = userflags | new_generation | ijha_h32_in_use_bit(self) | current_cursor;
+
+      self->freelist_dequeue_index = current_handle & self->capacity_mask;
+      ++self->size;
+      return current_cursor;
+   }
+}
+
+IJHA_H32_API unsigned ijha_h32_shared_release(struct ijha_h32_shared *self, unsigned handle)
+{
+   unsigned in_use_bit = ijha_h32_in_use_bit(self);
+   unsigned idx = handle & self->capacity_mask;
+   unsigned *stored_handle = ((self->capacity > idx) && (handle & in_use_bit)) ? ijha_h32_shared_handle_info_at(self, idx) : 0;
+
+   if (!stored_handle || *stored_handle != handle)
+      return IJHA_H32_INVALID_INDEX;
+
+#if IJHA_H32_HAS_ATOMICS
+   if (self->flags_num_userflag_bits & IJHA_H32_INIT_THREADSAFE)
+      return ijha_h32_shared__release_lifo_ts(self, handle, stored_handle);
+#endif
+
+   if (ijha_h32_is_fifo(self)) {
+      /* clear in_use-bit of current */
+      *stored_handle &= ~in_use_bit;
+
+      stored_handle = ijha_h32_shared_handle_info_at(self, self->freelist_enqueue_index);
+      IJHA_H32_assert((*stored_handle & in_use_bit) == 0);
+      *stored_handle = (*stored_handle & ~self->capacity_mask) | idx;
+
+      self->freelist_enqueue_index = idx;
+   } else {
+      /* clear in_use-bit and store current (soon the be old) cursor */
+      *stored_handle = ~in_use_bit & ((handle & ~self->capacity_mask) | self->freelist_dequeue_index);
+      self->freelist_dequeue_index = idx;
+   }
+
+   --self->size;
+   return idx;
+}
+
+IJHA_H32_API unsigned ijha_h32_shared_userflags_set(struct ijha_h32_shared *self, unsigned handle, unsigned userflags)
+{
+   unsigned ohandle, *p;
+   IJHA_H32_assert(((userflags) & (self)->userflags_mask) == (userflags));
+   IJHA_H32_assert(ijha_h32_shared_valid_mask(self, handle, ~self->userflags_mask));
+   p = ijha_h32_shared_handle_info_at(self, handle & self->capacity_mask), ohandle = *p;
+   *p = (ohandle & ~self->userflags_mask) | userflags;
+
+   return ohandle & self->userflags_mask;
+}
+
 #if defined(IJHA_H32_TEST) || defined(IJHA_H32_TEST_MAIN)
 
 #ifndef IJHA_H32_memset
@@ -798,12 +1550,6 @@ struct ijha_h32_test_userdata {
 #ifndef offsetof
    typedef unsigned int ijha_h32_uint32;
 
-   #ifdef _MSC_VER
-      typedef unsigned __int64 ijha_h32_uint64;
-   #else
-      typedef unsigned long long ijha_h32_uint64;
-   #endif
-
    #if defined(__ppc64__) || defined(__aarch64__) || defined(_M_X64) || defined(__x86_64__) || defined(__x86_64)
       typedef ijha_h32_uint64 ijha_h32_uintptr;
    #else
@@ -1152,11 +1898,452 @@ static void ijha_h32_test_constant_handles(void)
 #undef PUBLIC_API_SECONDARY_WINDOW_HANDLE
 }
 
+static void ijha_h32_test_invalidate_all(void)
+{
+#define IJHA_TEST_MAX_NUM_HANDLES 6
+#if defined(IJHA_H32_HAS_ATOMICS)
+   unsigned LIFO_FIFO_FLAGS[] = {IJHA_H32_INIT_LIFO, IJHA_H32_INIT_FIFO, IJHA_H32_INIT_THREADSAFE | IJHA_H32_INIT_LIFO};
+#else
+   unsigned LIFO_FIFO_FLAGS[] = {IJHA_H32_INIT_LIFO, IJHA_H32_INIT_FIFO};
+#endif
+   unsigned ijha_h32_memory_area[IJHA_TEST_MAX_NUM_HANDLES];
+   unsigned handles[IJHA_TEST_MAX_NUM_HANDLES], old_handles[IJHA_TEST_MAX_NUM_HANDLES];
+   struct ijha_h32 l, *self = &l;
+   unsigned idx, num = sizeof LIFO_FIFO_FLAGS / sizeof *LIFO_FIFO_FLAGS;
+   int init_res;
+
+   for (idx = 0; idx != num*2; ++idx) {
+      unsigned LIFO_FIFO_FLAG = LIFO_FIFO_FLAGS[idx%num];
+      unsigned i, j, round, maxnhandles, dummy;
+
+      if (idx >= num)
+         LIFO_FIFO_FLAG |= IJHA_H32_INIT_DONT_USE_MSB_AS_IN_USE_BIT;
+
+      init_res = ijha_h32_init_no_inlinehandles(self, IJHA_TEST_MAX_NUM_HANDLES, 0, 0, LIFO_FIFO_FLAG, ijha_h32_memory_area);
+      IJHA_H32_assert(init_res == IJHA_H32_INIT_NO_ERROR);
+      maxnhandles = ijha_h32_capacity(self);
+
+      for (i = 0; i != maxnhandles; ++i)
+         IJHA_H32_assert(ijha_h32_acquire(self, &handles[i]) != IJHA_H32_INVALID_INDEX);
+
+      for (round = 0; round != 3; ++round) {
+         /* release some to have both threaded and in-use slots at invalidation */
+         for (i = 0; i < maxnhandles; i += 2)
+            IJHA_H32_assert(ijha_h32_release(self, handles[i]) != IJHA_H32_INVALID_INDEX);
+
+         ijha_h32_invalidate_all(self);
+         IJHA_H32_assert(self->size == 0);
+         for (i = 0; i != maxnhandles; ++i) {
+            IJHA_H32_assert(!ijha_h32_valid(self, handles[i]));
+            IJHA_H32_assert(ijha_h32_release(self, handles[i]) == IJHA_H32_INVALID_INDEX);
+            old_handles[i] = handles[i];
+         }
+
+         for (i = 0; i != maxnhandles; ++i) {
+            unsigned si = ijha_h32_acquire(self, &handles[i]);
+            IJHA_H32_assert(si != IJHA_H32_INVALID_INDEX);
+            IJHA_H32_assert(si == ijha_h32_index(self, handles[i]));
+            for (j = 0; j != i + 1; ++j)
+               IJHA_H32_assert(ijha_h32_valid(self, handles[j]));
+            for (j = 0; j != maxnhandles; ++j)
+               IJHA_H32_assert(!ijha_h32_valid(self, old_handles[j]));
+         }
+         IJHA_H32_assert(ijha_h32_acquire(self, &dummy) == IJHA_H32_INVALID_INDEX);
+
+         /* releasing/reacquiring works as usual after all slots been threaded */
+         for (i = 0; i != maxnhandles; ++i)
+            IJHA_H32_assert(ijha_h32_release(self, handles[i]) != IJHA_H32_INVALID_INDEX);
+         for (i = 0; i != maxnhandles; ++i)
+            IJHA_H32_assert(ijha_h32_acquire(self, &handles[i]) != IJHA_H32_INVALID_INDEX);
+         IJHA_H32_assert(ijha_h32_acquire(self, &dummy) == IJHA_H32_INVALID_INDEX);
+         IJHA_H32_assert(self->size == maxnhandles);
+      }
+
+      /* partially threaded */
+      ijha_h32_invalidate_all(self);
+      for (i = 0; i != 2; ++i)
+         IJHA_H32_assert(ijha_h32_acquire(self, &handles[i]) != IJHA_H32_INVALID_INDEX);
+      IJHA_H32_assert(ijha_h32_release(self, handles[0]) != IJHA_H32_INVALID_INDEX);
+      IJHA_H32_assert(!ijha_h32_valid(self, handles[0]));
+      IJHA_H32_assert(ijha_h32_valid(self, handles[1]));
+      for (i = 2; i != maxnhandles + 1; ++i)
+         IJHA_H32_assert(ijha_h32_acquire(self, &handles[i % maxnhandles]) != IJHA_H32_INVALID_INDEX);
+      IJHA_H32_assert(ijha_h32_acquire(self, &dummy) == IJHA_H32_INVALID_INDEX);
+      for (i = 0; i != maxnhandles; ++i)
+         IJHA_H32_assert(ijha_h32_valid(self, handles[i]));
+   }
+#undef IJHA_TEST_MAX_NUM_HANDLES
+}
+
+static void ijha_h32_test_acquire_range(void)
+{
+#define IJHA_TEST_MAX_NUM_HANDLES 16
+   unsigned LIFO_FIFO_FLAGS[] = {IJHA_H32_INIT_LIFO, IJHA_H32_INIT_FIFO};
+   unsigned ijha_h32_memory_area[IJHA_TEST_MAX_NUM_HANDLES];
+   unsigned held[IJHA_TEST_MAX_NUM_HANDLES + 1], range[IJHA_TEST_MAX_NUM_HANDLES];
+   struct ijha_h32 l, *self = &l;
+   unsigned idx, num = sizeof LIFO_FIFO_FLAGS / sizeof *LIFO_FIFO_FLAGS;
+   unsigned rnd = 1;
+   int init_res;
+
+   for (idx = 0; idx != num*2; ++idx) {
+      unsigned LIFO_FIFO_FLAG = LIFO_FIFO_FLAGS[idx%num];
+      unsigned i, j, step, maxnhandles, numheld = 0;
+
+      if (idx >= num)
+         LIFO_FIFO_FLAG |= IJHA_H32_INIT_DONT_USE_MSB_AS_IN_USE_BIT;
+
+      init_res = ijha_h32_init_no_inlinehandles(self, IJHA_TEST_MAX_NUM_HANDLES, 0, 0, LIFO_FIFO_FLAG, ijha_h32_memory_area);
+      IJHA_H32_assert(init_res == IJHA_H32_INIT_NO_ERROR);
+      maxnhandles = ijha_h32_capacity(self);
+
+      for (step = 0; step != 2000; ++step) {
+         unsigned op, k, first;
+         rnd = rnd * 1103515245u + 12345u;
+         op = (rnd >> 16) % 8;
+         k = 1 + (rnd >> 24) % 5;
+
+         if (op == 0 && numheld) {
+            /* release a random one */
+            j = (rnd >> 8) % numheld;
+            IJHA_H32_assert(ijha_h32_release(self, held[j]) != IJHA_H32_INVALID_INDEX);
+            held[j] = held[--numheld];
+         } else if (op == 1) {
+            unsigned si = (rnd >> 4) & 1 ? ijha_h32_acquire_near(self, (rnd >> 8) % IJHA_TEST_MAX_NUM_HANDLES, 0, &held[numheld]) : ijha_h32_acquire(self, &held[numheld]);
+            if (si != IJHA_H32_INVALID_INDEX)
+               ++numheld;
+            else
+               IJHA_H32_assert(numheld == maxnhandles);
+         } else if (op == 2 && step % 64 == 2) {
+            ijha_h32_invalidate_all(self);
+            numheld = 0;
+         } else if (op < 5) {
+            first = ijha_h32_acquire_range(self, k, 0, range);
+            if (first != IJHA_H32_INVALID_INDEX) {
+               for (i = 0; i != k; ++i) {
+                  IJHA_H32_assert(ijha_h32_index(self, range[i]) == first + i);
+                  held[numheld++] = range[i];
+               }
+            } else {
+               IJHA_H32_assert(range[0] == 0);
+            }
+         } else if (numheld >= k) {
+            numheld -= k;
+            IJHA_H32_assert(ijha_h32_release_range(self, k, held + numheld) == k);
+            IJHA_H32_assert(ijha_h32_release_range(self, k, held + numheld) == 0);
+         }
+
+         IJHA_H32_assert(self->size == numheld);
+         for (i = 0; i != numheld; ++i)
+            IJHA_H32_assert(ijha_h32_valid(self, held[i]));
+      }
+
+      /* all slots must still be reachable */
+      IJHA_H32_assert(ijha_h32_release_range(self, numheld, held) == numheld);
+      for (i = 0; i != maxnhandles; ++i)
+         IJHA_H32_assert(ijha_h32_acquire(self, &held[i]) != IJHA_H32_INVALID_INDEX);
+      IJHA_H32_assert(ijha_h32_acquire(self, &held[maxnhandles]) == IJHA_H32_INVALID_INDEX);
+
+      /* after releasing everything a full range is available */
+      IJHA_H32_assert(ijha_h32_release_range(self, maxnhandles, held) == maxnhandles);
+      IJHA_H32_assert(ijha_h32_acquire_range(self, maxnhandles, 0, range) != IJHA_H32_INVALID_INDEX || ijha_h32_is_fifo(self));
+   }
+
+   /* FIFO: after 'ijha_h32_invalidate_all' the last slot is queued while being
+    * above the watermark, a range covering it must unlink it from the queue */
+   init_res = ijha_h32_init_no_inlinehandles(self, 4, 0, 0, IJHA_H32_INIT_FIFO, ijha_h32_memory_area);
+   IJHA_H32_assert(init_res == IJHA_H32_INIT_NO_ERROR);
+   ijha_h32_invalidate_all(self);
+   IJHA_H32_assert(ijha_h32_acquire(self, &held[0]) == 0);
+   IJHA_H32_assert(ijha_h32_release(self, held[0]) == 0);
+   IJHA_H32_assert(ijha_h32_acquire_range(self, 3, 0, range) == 1);
+   IJHA_H32_assert(ijha_h32_release(self, range[0]) == 1);
+   IJHA_H32_assert(ijha_h32_acquire(self, &held[0]) == 0);
+   IJHA_H32_assert(ijha_h32_valid(self, held[0]) && ijha_h32_valid(self, range[1]) && ijha_h32_valid(self, range[2]));
+   IJHA_H32_assert(ijha_h32_acquire(self, &held[1]) == IJHA_H32_INVALID_INDEX);
+   IJHA_H32_assert(self->size == 3);
+#undef IJHA_TEST_MAX_NUM_HANDLES
+}
+
+static void ijha_h32_test_acquire_near(void)
+{
+#define IJHA_TEST_MAX_NUM_HANDLES 32
+   unsigned LIFO_FIFO_FLAGS[] = {IJHA_H32_INIT_LIFO, IJHA_H32_INIT_FIFO};
+   unsigned ijha_h32_memory_area[IJHA_TEST_MAX_NUM_HANDLES];
+   unsigned handles[IJHA_TEST_MAX_NUM_HANDLES + 1];
+   struct ijha_h32 l, *self = &l;
+   unsigned idx, num = sizeof LIFO_FIFO_FLAGS / sizeof *LIFO_FIFO_FLAGS;
+   int init_res;
+
+   for (idx = 0; idx != num*2; ++idx) {
+      unsigned LIFO_FIFO_FLAG = LIFO_FIFO_FLAGS[idx%num];
+      unsigned i, maxnhandles;
+
+      if (idx >= num)
+         LIFO_FIFO_FLAG |= IJHA_H32_INIT_DONT_USE_MSB_AS_IN_USE_BIT;
+
+      init_res = ijha_h32_init_no_inlinehandles(self, IJHA_TEST_MAX_NUM_HANDLES, 0, 0, LIFO_FIFO_FLAG, ijha_h32_memory_area);
+      IJHA_H32_assert(init_res == IJHA_H32_INIT_NO_ERROR);
+      maxnhandles = ijha_h32_capacity(self);
+
+      for (i = 0; i != maxnhandles; ++i)
+         IJHA_H32_assert(ijha_h32_acquire(self, &handles[i]) == i);
+
+      IJHA_H32_assert(ijha_h32_release(self, handles[5]) == 5);
+      IJHA_H32_assert(ijha_h32_release(self, handles[20]) == 20);
+      IJHA_H32_assert(ijha_h32_release(self, handles[9]) == 9);
+
+      IJHA_H32_assert(ijha_h32_acquire_near(self, 19, 0, &handles[20]) == 20);
+      IJHA_H32_assert(ijha_h32_acquire_near(self, 4, 0, &handles[5]) == 5);
+      IJHA_H32_assert(ijha_h32_valid(self, handles[20]) && ijha_h32_valid(self, handles[5]));
+
+      if (ijha_h32_is_fifo(self)) {
+         /* the released slot 9 is the enqueue node, only the (free) last slot remains */
+         IJHA_H32_assert(ijha_h32_acquire_near(self, 10, 0, &handles[maxnhandles]) == maxnhandles);
+      } else {
+         IJHA_H32_assert(ijha_h32_acquire_near(self, 10, 0, &handles[9]) == 9);
+      }
+      IJHA_H32_assert(ijha_h32_acquire_near(self, 10, 0, &handles[0]) == IJHA_H32_INVALID_INDEX);
+
+      /* the first not yet threaded slot is also a candidate */
+      ijha_h32_invalidate_all(self);
+      IJHA_H32_assert(ijha_h32_acquire(self, &handles[0]) == 0);
+      IJHA_H32_assert(ijha_h32_acquire(self, &handles[1]) == 1);
+      IJHA_H32_assert(ijha_h32_release(self, handles[0]) == 0);
+      IJHA_H32_assert(ijha_h32_acquire_near(self, 3, 0, &handles[2]) == 2);
+      /* FIFO: the released slot 0 is the enqueue node */
+      IJHA_H32_assert(ijha_h32_acquire_near(self, 0, 0, &handles[0]) == (ijha_h32_is_fifo(self) ? 3u : 0u));
+      for (i = 3; i != maxnhandles; ++i)
+         IJHA_H32_assert(ijha_h32_acquire(self, &handles[i]) != IJHA_H32_INVALID_INDEX);
+      IJHA_H32_assert(ijha_h32_acquire(self, &handles[maxnhandles]) == IJHA_H32_INVALID_INDEX);
+      for (i = 0; i != maxnhandles; ++i)
+         IJHA_H32_assert(ijha_h32_valid(self, handles[i]));
+   }
+
+   /* FIFO: after 'ijha_h32_invalidate_all' the queued last slot is above the
+    * watermark and must not be picked, as the handle would not be valid */
+   init_res = ijha_h32_init_no_inlinehandles(self, 8, 0, 0, IJHA_H32_INIT_FIFO, ijha_h32_memory_area);
+   IJHA_H32_assert(init_res == IJHA_H32_INIT_NO_ERROR);
+   ijha_h32_invalidate_all(self);
+   IJHA_H32_assert(ijha_h32_acquire(self, &handles[0]) == 0);
+   IJHA_H32_assert(ijha_h32_release(self, handles[0]) == 0);
+   IJHA_H32_assert(ijha_h32_acquire_near(self, 7, 0, &handles[0]) == 1);
+   IJHA_H32_assert(ijha_h32_valid(self, handles[0]));
+   IJHA_H32_assert(ijha_h32_release(self, handles[0]) == 1);
+   IJHA_H32_assert(self->size == 0);
+#undef IJHA_TEST_MAX_NUM_HANDLES
+}
+
+#if IJHA_H32_HAS_WAIT
+
+#if _WIN32
+   #include <process.h>
+
+   IJHA_H32__EXTERNC_DECL_BEGIN
+      __declspec(dllimport) unsigned long __stdcall WaitForSingleObject(void *hHandle, unsigned long dwMilliseconds);
+      __declspec(dllimport) int __stdcall CloseHandle(void *hObject);
+   IJHA_H32__EXTERNC_DECL_END
+#else
+   #include <pthread.h>
+#endif
+
+struct ijha_h32_test_waiter {
+   struct ijha_h32 *self;
+   unsigned handle;
+   unsigned idx;
+#if _WIN32
+   void *thread;
+#else
+   pthread_t thread;
+#endif
+};
+
+#if _WIN32
+static unsigned __stdcall ijha_h32_test_waiter_thread(void *arg)
+#else
+static void *ijha_h32_test_waiter_thread(void *arg)
+#endif
+{
+   struct ijha_h32_test_waiter *waiter = (struct ijha_h32_test_waiter*)arg;
+   waiter->idx = ijha_h32_acquire_wait(waiter->self, 0, &waiter->handle, IJHA_H32_WAIT_INFINITE);
+   return 0;
+}
+
+static void ijha_h32_test_waiter_start(struct ijha_h32_test_waiter *waiter)
+{
+#if _WIN32
+   waiter->thread = (void*)_beginthreadex(0, 0, ijha_h32_test_waiter_thread, waiter, 0, 0);
+   IJHA_H32_assert(waiter->thread != 0);
+#else
+   IJHA_H32_assert(pthread_create(&waiter->thread, 0, ijha_h32_test_waiter_thread, waiter) == 0);
+#endif
+}
+
+static void ijha_h32_test_waiter_join(struct ijha_h32_test_waiter *waiter)
+{
+#if _WIN32
+   WaitForSingleObject(waiter->thread, 0xffffffff);
+   CloseHandle(waiter->thread);
+#else
+   pthread_join(waiter->thread, 0);
+#endif
+}
+
+static void ijha_h32_test_acquire_wait(void)
+{
+#define IJHA_TEST_MAX_NUM_HANDLES 4
+   unsigned ijha_h32_memory_area[IJHA_TEST_MAX_NUM_HANDLES];
+   unsigned handles[IJHA_TEST_MAX_NUM_HANDLES];
+   struct ijha_h32_test_waiter waiters[2];
+   struct ijha_h32 l, *self = &l;
+   unsigned i, dummy, maxnhandles;
+   ijha_h32_uint64 start;
+   int init_res;
+
+   init_res = ijha_h32_init_no_inlinehandles(self, IJHA_TEST_MAX_NUM_HANDLES, 0, 0, IJHA_H32_INIT_THREADSAFE, ijha_h32_memory_area);
+   IJHA_H32_assert(init_res == IJHA_H32_INIT_NO_ERROR);
+   maxnhandles = ijha_h32_capacity(self);
+
+   for (i = 0; i != maxnhandles; ++i)
+      IJHA_H32_assert(ijha_h32_acquire_wait(self, 0, &handles[i], IJHA_H32_WAIT_INFINITE) != IJHA_H32_INVALID_INDEX);
+
+   IJHA_H32_assert(ijha_h32_acquire_wait(self, 0, &dummy, 0) == IJHA_H32_INVALID_INDEX);
+
+   start = ijha_h32__now_ns();
+   IJHA_H32_assert(ijha_h32_acquire_wait(self, 0, &dummy, 2000000) == IJHA_H32_INVALID_INDEX);
+   IJHA_H32_assert(ijha_h32__now_ns() - start >= 2000000);
+   IJHA_H32_assert(self->num_waiters == 0);
+
+   IJHA_H32_assert(ijha_h32_release(self, handles[1]) != IJHA_H32_INVALID_INDEX);
+   IJHA_H32_assert(ijha_h32_acquire_wait(self, 0, &handles[1], 2000000) != IJHA_H32_INVALID_INDEX);
+   for (i = 0; i != maxnhandles; ++i)
+      IJHA_H32_assert(ijha_h32_valid(self, handles[i]));
+
+   /* threads blocked in 'ijha_h32_acquire_wait' is woken, one per release, by
+    * releases on another thread */
+   for (i = 0; i != 2; ++i) {
+      waiters[i].self = self;
+      waiters[i].idx = IJHA_H32_INVALID_INDEX;
+      ijha_h32_test_waiter_start(&waiters[i]);
+   }
+   while (*(volatile unsigned*)&self->num_waiters != 2)
+      ;
+   /* give the waiters time to block in the kernel */
+   start = ijha_h32__now_ns();
+   while (ijha_h32__now_ns() - start < 20000000)
+      ;
+   IJHA_H32_assert(ijha_h32_release(self, handles[0]) != IJHA_H32_INVALID_INDEX);
+   IJHA_H32_assert(ijha_h32_release(self, handles[2]) != IJHA_H32_INVALID_INDEX);
+   for (i = 0; i != 2; ++i) {
+      ijha_h32_test_waiter_join(&waiters[i]);
+      IJHA_H32_assert(waiters[i].idx != IJHA_H32_INVALID_INDEX);
+      IJHA_H32_assert(ijha_h32_valid(self, waiters[i].handle));
+   }
+   IJHA_H32_assert(waiters[0].idx != waiters[1].idx);
+   IJHA_H32_assert(self->num_waiters == 0);
+   IJHA_H32_assert(self->size == maxnhandles);
+#undef IJHA_TEST_MAX_NUM_HANDLES
+}
+
+#endif /* IJHA_H32_HAS_WAIT */
+
+static void ijha_h32_test_shared(void)
+{
+#define IJHA_TEST_MAX_NUM_HANDLES 7
+#if defined(IJHA_H32_HAS_ATOMICS)
+   unsigned LIFO_FIFO_FLAGS[] = {IJHA_H32_INIT_LIFO, IJHA_H32_INIT_FIFO, IJHA_H32_INIT_THREADSAFE | IJHA_H32_INIT_LIFO};
+#else
+   unsigned LIFO_FIFO_FLAGS[] = {IJHA_H32_INIT_LIFO, IJHA_H32_INIT_FIFO};
+#endif
+   struct ijha_h32_test_shared_segment {
+      struct ijha_h32_shared instance;
+      struct ijha_h32_test_userdata userdata[IJHA_TEST_MAX_NUM_HANDLES];
+   };
+   /* the second segment simulates the same memory being mapped at another address */
+   struct ijha_h32_test_shared_segment segment_a, segment_b;
+   struct ijha_h32_shared *self;
+   unsigned idx, num = sizeof LIFO_FIFO_FLAGS / sizeof *LIFO_FIFO_FLAGS;
+   unsigned i, maxnhandles, dummy, handles[IJHA_TEST_MAX_NUM_HANDLES];
+   int init_res;
+
+   /* memory located before the instance is not supported */
+   self = (struct ijha_h32_shared*)&segment_b.userdata[1];
+   init_res = ijha_h32_shared_init_no_inlinehandles(self, IJHA_TEST_MAX_NUM_HANDLES, 0, 0, IJHA_H32_INIT_LIFO, segment_b.userdata);
+   IJHA_H32_assert(init_res == IJHA_H32_INIT_MEMORY_OFFSET_INVALID);
+   /* nor memory overlapping the instance */
+   self = &segment_b.instance;
+   init_res = ijha_h32_shared_init_no_inlinehandles(self, IJHA_TEST_MAX_NUM_HANDLES, 0, 0, IJHA_H32_INIT_LIFO, (unsigned char*)self + sizeof *self - sizeof(unsigned));
+   IJHA_H32_assert(init_res == IJHA_H32_INIT_MEMORY_OFFSET_INVALID);
+
+   for (idx = 0; idx != num*2; ++idx) {
+      unsigned LIFO_FIFO_FLAG = LIFO_FIFO_FLAGS[idx%num];
+      unsigned num_userflag_bits = 2;
+      if (idx >= num)
+         LIFO_FIFO_FLAG |= IJHA_H32_INIT_DONT_USE_MSB_AS_IN_USE_BIT;
+
+      self = &segment_a.instance;
+      init_res = ijha_h32_shared_init_inlinehandles(self, IJHA_TEST_MAX_NUM_HANDLES, num_userflag_bits, sizeof(struct ijha_h32_test_userdata), ijha_h32_test_offsetof(struct ijha_h32_test_userdata, inline_handle), LIFO_FIFO_FLAG, segment_a.userdata);
+      IJHA_H32_assert(init_res == IJHA_H32_INIT_NO_ERROR);
+      maxnhandles = ijha_h32_capacity(self);
+
+      for (i = 0; i != maxnhandles; ++i) {
+         unsigned userflags = ijha_h32_userflags_to_handle(self, i&3);
+         unsigned si = ijha_h32_shared_acquire_userflags(self, userflags, &handles[i]);
+         IJHA_H32_assert(si != IJHA_H32_INVALID_INDEX);
+         IJHA_H32_assert(ijha_h32_shared_valid(self, handles[i]));
+         IJHA_H32_assert(ijha_h32_shared_in_use_index(self, si));
+         IJHA_H32_assert(ijha_h32_shared_userflags(self, handles[i]) == userflags);
+         IJHA_H32_assert(ijha_h32_shared_userdata(struct ijha_h32_test_userdata*, self, si) == &segment_a.userdata[si]);
+         ijha_h32_shared_userdata(struct ijha_h32_test_userdata*, self, si)->a = i;
+      }
+      IJHA_H32_assert(ijha_h32_shared_acquire(self, &dummy) == IJHA_H32_INVALID_INDEX);
+
+      /* 'map' the memory at another address and continue using it from there */
+      segment_b = segment_a;
+      IJHA_H32_memset(&segment_a, 0, sizeof segment_a);
+      self = &segment_b.instance;
+
+      for (i = 0; i != maxnhandles; ++i) {
+         struct ijha_h32_test_userdata *userdata = ijha_h32_shared_userdata_checked(struct ijha_h32_test_userdata*, self, handles[i]);
+         IJHA_H32_assert(userdata && userdata->a == i);
+         IJHA_H32_assert(userdata == &segment_b.userdata[ijha_h32_index(self, handles[i])]);
+      }
+
+      for (i = 0; i != maxnhandles; ++i) {
+         unsigned si = ijha_h32_shared_release(self, handles[i]);
+         IJHA_H32_assert(si == ijha_h32_index(self, handles[i]));
+         IJHA_H32_assert(!ijha_h32_shared_valid(self, handles[i]));
+         IJHA_H32_assert(ijha_h32_shared_release(self, handles[i]) == IJHA_H32_INVALID_INDEX);
+      }
+      IJHA_H32_assert(self->size == 0);
+
+      for (i = 0; i != maxnhandles; ++i) {
+         unsigned si = ijha_h32_shared_acquire(self, &handles[i]);
+         IJHA_H32_assert(si != IJHA_H32_INVALID_INDEX);
+         IJHA_H32_assert(ijha_h32_shared_valid(self, handles[i]));
+      }
+      IJHA_H32_assert(ijha_h32_shared_acquire(self, &dummy) == IJHA_H32_INVALID_INDEX);
+
+      ijha_h32_shared_reset(self);
+      for (i = 0; i != maxnhandles; ++i)
+         IJHA_H32_assert(!ijha_h32_shared_valid(self, handles[i]));
+      IJHA_H32_assert(self->size == 0);
+   }
+#undef IJHA_TEST_MAX_NUM_HANDLES
+}
+
 static void ijha_h32_test_suite(void)
 {
    ijha_h32_test_basic_operations();
    ijha_h32_test_inline_noinline_handles();
    ijha_h32_test_constant_handles();
+   ijha_h32_test_invalidate_all();
+   ijha_h32_test_acquire_range();
+   ijha_h32_test_acquire_near();
+#if IJHA_H32_HAS_WAIT
+   ijha_h32_test_acquire_wait();
+#endif
+   ijha_h32_test_shared();
 }
 
 #if defined(IJHA_H32_TEST_MAIN)
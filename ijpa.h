@@ -0,0 +1,357 @@
+/* clang-format off */
+
+/*
+ijpa : IncredibleJunior PackedArray
+
+packed array object pool [1] that combines the stable handles of ijha_h32 with
+densely packed userdata kept by ijss.
+
+acquire returns a 'ijha_h32' handle and the userdata is stored packed in
+[0, size), a sparse set maps the index of the handle to the dense slot of the
+userdata. release moves the last userdata into the hole (swap-remove) so the
+userdata always stays packed, while the handles of the other objects stays valid.
+this gives O(1) handle -> userdata lookup (two indirections) and linear iteration
+of all live objects.
+
+   struct MyObject { float x, y, z; };
+
+   unsigned max_num_objects = 1024;
+   struct ijpa pool;
+   void *memory = malloc(ijpa_memory_size_needed(max_num_objects, sizeof(struct MyObject)));
+   ijpa_init(&pool, max_num_objects, 0, sizeof(struct MyObject), IJHA_H32_INIT_LIFO, memory);
+
+   unsigned handle, i;
+   ijpa_acquire(&pool, &handle);
+   ijpa_userdata(struct MyObject *, &pool, handle)->x = 1.0f;
+
+   for (i = 0; i != ijpa_size(&pool); ++i) {
+      struct MyObject *o = ijpa_userdata_at(struct MyObject *, &pool, i);
+      unsigned owner = ijpa_handle_at(&pool, i);
+      ...
+   }
+
+   ijpa_release(&pool, handle);
+
+This file provides both the interface and the implementation.
+The pool is implemented as a stb-style header-file library[2] on top of
+ijha_h32.h and ijss.h, which must be found on the include path, and their
+implementation must be compiled in one source file as well. In *ONE* source file, put:
+
+#define IJPA_IMPLEMENTATION
+#define IJHA_H32_IMPLEMENTATION
+#define IJSS_IMPLEMENTATION
+// if custom memcpy wanted (and no dependencies on string.h)
+#define IJPA_memcpy   custom_memcpy
+#include "ijpa.h"
+
+Other source files should just include ijpa.h
+
+EXAMPLES/UNIT TESTS
+   Usage examples+tests is at the bottom of the file in the IJPA_TEST section.
+LICENSE
+   See end of file for license information
+
+References:
+   [1] http://bitsquid.blogspot.se/2011/09/managing-decoupling-part-4-id-lookup.html
+   [2] https://github.com/nothings/stb
+
+*/
+
+#ifndef IJPA_INCLUDED_H
+#define IJPA_INCLUDED_H
+
+#include "ijha_h32.h"
+#include "ijss.h"
+
+#ifdef __cplusplus
+   extern "C" {
+#endif
+
+#if defined(IJPA_STATIC)
+   #define IJPA_API static
+#else
+   #define IJPA_API extern
+#endif
+
+#define IJPA_INVALID_INDEX (0xffffffffu)
+
+struct ijpa {
+   /* handle -> sparse index, no userdata is stored with the handles */
+   struct ijha_h32 handles;
+   /* sparse index (of the handle) <-> dense index (of the userdata) */
+   struct ijss map;
+   /* 'map.size' packed userdata items of 'userdata_size' bytes */
+   void *userdata;
+   unsigned userdata_size;
+};
+
+/* size of the memory to pass to 'ijpa_init' (size of 'struct ijpa' is *NOT* included).
+ * the userdata is placed first in the memory, so it has the alignment of the memory */
+IJPA_API unsigned ijpa_memory_size_needed(unsigned max_num_handles, unsigned userdata_size);
+
+/* returns 0 (IJHA_H32_INIT_NO_ERROR) on success else the 'enum ijha_h32_init_res'
+ * error of the handles. the pool is not thread-safe, IJHA_H32_INIT_THREADSAFE
+ * gives IJHA_H32_INIT_THREADSAFE_UNSUPPORTED */
+IJPA_API int ijpa_init(struct ijpa *self, unsigned max_num_handles, unsigned num_userflag_bits, unsigned userdata_size, unsigned ijha_flags, void *memory);
+
+/* releases all handles */
+IJPA_API void ijpa_reset(struct ijpa *self);
+
+/* returns the dense index of the (uninitialized) userdata of the new handle
+ * or IJPA_INVALID_INDEX if the pool is full, see 'ijha_h32_acquire_userflags' */
+IJPA_API unsigned ijpa_acquire_userflags(struct ijpa *self, unsigned userflags, unsigned *handle_out);
+#define ijpa_acquire(self, handle_out) ijpa_acquire_userflags((self), 0, (handle_out))
+
+/* releases the handle and moves the last userdata into the slot of the released.
+ * returns the dense index of the released userdata (now holding what was
+ * the last userdata unless it was the last) or IJPA_INVALID_INDEX if the handle is invalid */
+IJPA_API unsigned ijpa_release(struct ijpa *self, unsigned handle);
+
+/* number of live handles, i.e. userdata is in [0, size) */
+#define ijpa_size(self) ((self)->map.size)
+#define ijpa_capacity(self) ijha_h32_capacity(&(self)->handles)
+#define ijpa_valid(self, handle) ijha_h32_valid(&(self)->handles, (handle))
+
+/* dense index of a valid handle */
+#define ijpa_dense_index(self, handle) ijss_dense_index(&(self)->map, ijha_h32_index(&(self)->handles, (handle)))
+/* handle of the userdata at dense index */
+#define ijpa_handle_at(self, dense_index) (*ijha_h32_handle_info_at(&(self)->handles, ijss_sparse_index(&(self)->map, (dense_index))))
+
+#define ijpa_userdata_at(userdata_type, self, dense_index) ijha_h32_pointer_add(userdata_type, (self)->userdata, (self)->userdata_size * (dense_index))
+/* NB: 'ijpa_userdata' assumes a valid handle, 'ijpa_userdata_checked' returns 0 for invalid handles */
+#define ijpa_userdata(userdata_type, self, handle) ijpa_userdata_at(userdata_type, (self), ijpa_dense_index((self), (handle)))
+#define ijpa_userdata_checked(userdata_type, self, handle) (ijpa_valid((self), (handle)) ? ijpa_userdata(userdata_type, (self), (handle)) : 0)
+
+#ifdef __cplusplus
+   }
+#endif
+
+#endif /* IJPA_INCLUDED_H */
+
+#if defined(IJPA_TEST_MAIN)
+   #define IJHA_H32_IMPLEMENTATION
+   #define IJSS_IMPLEMENTATION
+   #include "ijha_h32.h"
+   #include "ijss.h"
+#endif
+
+#if defined(IJPA_IMPLEMENTATION) && !defined(IJPA_IMPLEMENTATION_DEFINED)
+
+#define IJPA_IMPLEMENTATION_DEFINED (1)
+
+#ifndef IJPA_memcpy
+   #include <string.h>
+   #define IJPA_memcpy memcpy
+#endif
+
+#define ijpa__userdata_size_aligned(max_num_handles, userdata_size) (((max_num_handles) * (userdata_size) + 3) & ~3u)
+
+IJPA_API unsigned ijpa_memory_size_needed(unsigned max_num_handles, unsigned userdata_size)
+{
+   return ijpa__userdata_size_aligned(max_num_handles, userdata_size) + max_num_handles * sizeof(struct ijss_pair32) + ijha_h32_memory_size_needed(max_num_handles, 0, 0);
+}
+
+IJPA_API int ijpa_init(struct ijpa *self, unsigned max_num_handles, unsigned num_userflag_bits, unsigned userdata_size, unsigned ijha_flags, void *memory)
+{
+   unsigned char *pairs = (unsigned char *)memory + ijpa__userdata_size_aligned(max_num_handles, userdata_size);
+   unsigned char *handles = pairs + max_num_handles * sizeof(struct ijss_pair32);
+   int init_res;
+
+   if (ijha_flags & IJHA_H32_INIT_THREADSAFE)
+      return IJHA_H32_INIT_THREADSAFE_UNSUPPORTED;
+
+   init_res = ijha_h32_init_no_inlinehandles(&self->handles, max_num_handles, num_userflag_bits, 0, ijha_flags, handles);
+   if (init_res != IJHA_H32_INIT_NO_ERROR)
+      return init_res;
+
+   ijss_init_from_pairtype(struct ijss_pair32, &self->map, pairs, sizeof(struct ijss_pair32), max_num_handles);
+   self->userdata = memory;
+   self->userdata_size = userdata_size;
+   return IJHA_H32_INIT_NO_ERROR;
+}
+
+IJPA_API void ijpa_reset(struct ijpa *self)
+{
+   ijha_h32_reset(&self->handles);
+   ijss_reset(&self->map);
+}
+
+IJPA_API unsigned ijpa_acquire_userflags(struct ijpa *self, unsigned userflags, unsigned *handle_out)
+{
+   unsigned sparse_index = ijha_h32_acquire_userflags(&self->handles, userflags, handle_out);
+   if (sparse_index == IJHA_H32_INVALID_INDEX)
+      return IJPA_INVALID_INDEX;
+
+   return ijss_add(&self->map, sparse_index);
+}
+
+IJPA_API unsigned ijpa_release(struct ijpa *self, unsigned handle)
+{
+   unsigned sparse_index, dense_index, move_to, move_from;
+   if (!ijpa_valid(self, handle))
+      return IJPA_INVALID_INDEX;
+
+   sparse_index = ijha_h32_release(&self->handles, handle);
+   dense_index = ijss_dense_index(&self->map, sparse_index);
+   if (ijss_remove(&self->map, sparse_index, &move_to, &move_from) > 0)
+      IJPA_memcpy(ijpa_userdata_at(void *, self, move_to), ijpa_userdata_at(void *, self, move_from), self->userdata_size);
+
+   return dense_index;
+}
+
+#if defined(IJPA_TEST) || defined(IJPA_TEST_MAIN)
+
+#ifndef IJPA_assert
+   #include <assert.h>
+   #define IJPA_assert assert
+#endif
+
+struct ijpa_test_object {
+   unsigned handle;
+   unsigned value;
+};
+
+static void ijpa_test_pool(unsigned ijha_flags)
+{
+#define IJPA_TEST_MAX_NUM_HANDLES (300)
+   static unsigned char memory[IJPA_TEST_MAX_NUM_HANDLES * (sizeof(struct ijpa_test_object) + sizeof(struct ijss_pair32) + sizeof(unsigned))];
+   static unsigned live_handles[IJPA_TEST_MAX_NUM_HANDLES], stale_handles[IJPA_TEST_MAX_NUM_HANDLES];
+   unsigned num_live = 0, num_stale = 0, i, round, rnd = 4711, capacity;
+   struct ijpa pool;
+
+   IJPA_assert(ijpa_memory_size_needed(IJPA_TEST_MAX_NUM_HANDLES, sizeof(struct ijpa_test_object)) == sizeof memory);
+   IJPA_assert(ijpa_init(&pool, IJPA_TEST_MAX_NUM_HANDLES, 2, sizeof(struct ijpa_test_object), ijha_flags, memory) == IJHA_H32_INIT_NO_ERROR);
+   IJPA_assert(ijpa_init(&pool, IJPA_TEST_MAX_NUM_HANDLES, 0, sizeof(struct ijpa_test_object), ijha_flags | IJHA_H32_INIT_THREADSAFE, memory) == IJHA_H32_INIT_THREADSAFE_UNSUPPORTED);
+   IJPA_assert(ijpa_init(&pool, IJPA_TEST_MAX_NUM_HANDLES, 2, sizeof(struct ijpa_test_object), ijha_flags, memory) == IJHA_H32_INIT_NO_ERROR);
+   capacity = ijpa_capacity(&pool);
+
+   for (round = 0; round != 20000; ++round) {
+      rnd = rnd * 1103515245u + 12345u;
+      if (((rnd >> 16) % 5) < 3) {
+         unsigned handle, userflags = (rnd >> 8) & 3;
+         unsigned dense_index = ijpa_acquire_userflags(&pool, ijha_h32_userflags_to_handle(&pool.handles, userflags), &handle);
+         if (num_live == capacity) {
+            IJPA_assert(dense_index == IJPA_INVALID_INDEX);
+         } else {
+            struct ijpa_test_object *o;
+            IJPA_assert(dense_index == num_live);
+            IJPA_assert(ijpa_valid(&pool, handle));
+            IJPA_assert(ijha_h32_userflags_from_handle(&pool.handles, handle) == userflags);
+            o = ijpa_userdata_at(struct ijpa_test_object *, &pool, dense_index);
+            IJPA_assert(o == ijpa_userdata(struct ijpa_test_object *, &pool, handle));
+            o->handle = handle;
+            o->value = handle * 3;
+            live_handles[num_live++] = handle;
+         }
+      } else if (num_live) {
+         unsigned pick = (rnd >> 8) % num_live, handle = live_handles[pick];
+         unsigned dense_index = ijpa_dense_index(&pool, handle);
+         IJPA_assert(ijpa_release(&pool, handle) == dense_index);
+         IJPA_assert(!ijpa_valid(&pool, handle));
+         IJPA_assert(ijpa_release(&pool, handle) == IJPA_INVALID_INDEX);
+         live_handles[pick] = live_handles[--num_live];
+         if (num_stale != IJPA_TEST_MAX_NUM_HANDLES)
+            stale_handles[num_stale++] = handle;
+      }
+      IJPA_assert(ijpa_size(&pool) == num_live);
+
+      if ((round & 255) == 0) {
+         /* userdata is packed and follows the handles */
+         for (i = 0; i != ijpa_size(&pool); ++i) {
+            struct ijpa_test_object *o = ijpa_userdata_at(struct ijpa_test_object *, &pool, i);
+            IJPA_assert(ijpa_handle_at(&pool, i) == o->handle);
+            IJPA_assert(o->value == o->handle * 3);
+            IJPA_assert(ijpa_dense_index(&pool, o->handle) == i);
+         }
+         for (i = 0; i != num_live; ++i)
+            IJPA_assert(ijpa_userdata_checked(struct ijpa_test_object *, &pool, live_handles[i])->handle == live_handles[i]);
+         for (i = 0; i != num_stale; ++i) {
+            IJPA_assert(!ijpa_valid(&pool, stale_handles[i]));
+            IJPA_assert(ijpa_userdata_checked(struct ijpa_test_object *, &pool, stale_handles[i]) == 0);
+         }
+         num_stale = 0;
+      }
+   }
+
+   ijpa_reset(&pool);
+   IJPA_assert(ijpa_size(&pool) == 0);
+   for (i = 0; i != num_live; ++i)
+      IJPA_assert(!ijpa_valid(&pool, live_handles[i]));
+#undef IJPA_TEST_MAX_NUM_HANDLES
+}
+
+static void ijpa_test_suite(void)
+{
+   ijpa_test_pool(IJHA_H32_INIT_LIFO);
+   ijpa_test_pool(IJHA_H32_INIT_FIFO);
+   ijpa_test_pool(IJHA_H32_INIT_LIFO | IJHA_H32_INIT_DONT_USE_MSB_AS_IN_USE_BIT);
+}
+
+#if defined(IJPA_TEST_MAIN)
+
+#include <stdio.h>
+
+int main(int args, char **argc)
+{
+   (void)args;
+   (void)argc;
+   ijpa_test_suite();
+   printf("ijpa: all tests done.\n");
+   return 0;
+}
+#endif
+
+#endif /* defined(IJPA_TEST) || defined(IJPA_TEST_MAIN) */
+#endif /* defined(IJPA_IMPLEMENTATION) */
+
+/*
+LICENSE
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - 3-Clause BSD License
+Copyright (c) 2019-, Fredrik Engkvist
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the copyright holder nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+software, either in source code form or as a compiled binary, for any purpose,
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this
+software dedicate any and all copyright interest in the software to the public
+domain. We make this dedication for the benefit of the public at large and to
+the detriment of our heirs and successors. We intend this dedication to be an
+overt act of relinquishment in perpetuity of all present and future rights to
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
+/* clang-format on */
@@ -0,0 +1,590 @@
+/* clang-format off */
+
+/*
+ijsm : IncredibleJunior SecondaryMap
+
+secondary map for attaching extra data to (a subset of) handles from a
+ijha_h32 handle allocator. the map is indexed by 'ijha_h32_index' of the handle
+and stores the owning handle next to the value, so a lookup is one index
+operation plus one compare instead of a hash probe, and the entry of a handle is
+never returned for another generation of the handle (i.e. a handle that reused the index).
+
+two variants with the same semantics is provided:
+
+ - 'struct ijsm_paged' (sparse storage): entries is stored directly at the handle
+   index in fixed size pages which is allocated on demand. best when lookups
+   dominate or the handle index space is densely populated by the map.
+
+ - 'struct ijsm_dense' (dense storage): entries is packed in [0, size) and a
+   sparse set (ijss) maps the handle index to the dense slot. memory for the
+   entries is only needed for the max number of attached handles and the
+   entries can be iterated linearly.
+
+an entry of a released handle stays in the map (and is still found with the
+released handle) until it is removed, replaced by an insert of a newer handle
+with the same index or, for the dense variant, purged with
+'ijsm_dense_remove_stale'. a newer handle never sees the entry of an older.
+
+NB: the value is stored after the 4 byte handle in an entry, so the values is
+    only guaranteed to be 4 byte aligned.
+
+   struct ijha_h32 handles; // initialized elsewhere
+   void *page_table[IJSM_NUM_PAGES(max_num_handles)];
+   struct ijsm_paged debug_names;
+   ijsm_paged_init(&debug_names, &handles, sizeof(const char*), page_table, IJSM_NUM_PAGES(max_num_handles), my_allocate_page, 0);
+
+   const char **name = (const char **)ijsm_paged_insert(&debug_names, handle);
+   if (name)
+      *name = "player";
+   ...
+   name = (const char **)ijsm_paged_get(&debug_names, handle); // 0 if not attached
+
+This file provides both the interface and the implementation.
+The map is implemented as a stb-style header-file library[1] on top of
+ijha_h32.h and ijss.h, which must be found on the include path, and their
+implementation must be compiled in one source file as well. In *ONE* source file, put:
+
+#define IJSM_IMPLEMENTATION
+#define IJHA_H32_IMPLEMENTATION
+#define IJSS_IMPLEMENTATION
+// if custom assert wanted (and no dependencies on assert.h)
+#define IJSM_assert   custom_assert
+#include "ijsm.h"
+
+Other source files should just include ijsm.h
+
+EXAMPLES/UNIT TESTS
+   Usage examples+tests is at the bottom of the file in the IJSM_TEST section.
+LICENSE
+   See end of file for license information
+
+References:
+   [1] https://github.com/nothings/stb
+
+*/
+
+#ifndef IJSM_INCLUDED_H
+#define IJSM_INCLUDED_H
+
+#include "ijha_h32.h"
+#include "ijss.h"
+
+#ifdef __cplusplus
+   extern "C" {
+#endif
+
+#if defined(IJSM_STATIC)
+   #define IJSM_API static
+#else
+   #define IJSM_API extern
+#endif
+
+/* number of entries per page (a power of 2) of 'struct ijsm_paged' */
+#ifndef IJSM_PAGE_SHIFT
+   #define IJSM_PAGE_SHIFT (8)
+#endif
+#define IJSM_PAGE_SIZE (1u << IJSM_PAGE_SHIFT)
+
+/* number of pages needed to cover the handle indices of a handle allocator with 'capacity' */
+#define IJSM_NUM_PAGES(capacity) (((capacity) + IJSM_PAGE_SIZE - 1) >> IJSM_PAGE_SHIFT)
+
+/* bytes per entry, the owning handle followed by the value */
+#define IJSM_ENTRY_STRIDE(value_size) ((sizeof(unsigned) + (value_size) + 3) & ~3u)
+
+struct ijsm_paged {
+   void **pages; /* 'num_pages' entries, null until allocated */
+   unsigned num_pages;
+   unsigned num_allocated_pages;
+   unsigned index_mask; /* 'capacity_mask' of the handle allocator */
+   unsigned stride;
+   unsigned size; /* number of entries, including the ones of stale handles */
+   /* must return 'page_size_in_bytes' of memory (the contents does not matter) or null on failure */
+   void *(*allocate_page)(void *user_data, unsigned page_size_in_bytes);
+   void *user_data;
+};
+
+/* 'pages' must have room for 'num_pages', at least IJSM_NUM_PAGES(handles->capacity).
+ * pages is never freed by the map, they are owned by the caller */
+IJSM_API void ijsm_paged_init(struct ijsm_paged *self, const struct ijha_h32 *handles, unsigned value_size, void **pages, unsigned num_pages, void *(*allocate_page)(void *user_data, unsigned page_size_in_bytes), void *user_data);
+
+/* returns the value of the handle, inserting it (with an uninitialized value)
+ * if not present. an entry of a stale handle at the same index is replaced.
+ * returns 0 if the page could not be allocated */
+IJSM_API void *ijsm_paged_insert(struct ijsm_paged *self, unsigned handle);
+
+/* returns the value of the handle or 0 if not present (i.e. the entry belongs
+ * to another generation, or the handle is 0 or outside of the pages) */
+IJSM_API void *ijsm_paged_get(struct ijsm_paged *self, unsigned handle);
+
+/* returns 1 if the handle was present and removed else 0 */
+IJSM_API int ijsm_paged_remove(struct ijsm_paged *self, unsigned handle);
+
+#define ijsm_paged_contains(self, handle) (ijsm_paged_get((self), (handle)) != 0)
+
+struct ijsm_dense {
+   struct ijss map; /* handle index <-> dense index */
+   void *entries; /* 'map.size' packed entries */
+   unsigned index_mask; /* 'capacity_mask' of the handle allocator */
+   unsigned stride;
+};
+
+/* size of the memory to pass to 'ijsm_dense_init' for a map with room for
+ * 'capacity' entries (size of 'struct ijsm_dense' is *NOT* included) */
+IJSM_API unsigned ijsm_dense_memory_size_needed(const struct ijha_h32 *handles, unsigned capacity, unsigned value_size);
+
+IJSM_API void ijsm_dense_init(struct ijsm_dense *self, const struct ijha_h32 *handles, unsigned capacity, unsigned value_size, void *memory);
+
+IJSM_API void ijsm_dense_reset(struct ijsm_dense *self);
+
+/* same as 'ijsm_paged_insert' but returns 0 if the map is full */
+IJSM_API void *ijsm_dense_insert(struct ijsm_dense *self, unsigned handle);
+IJSM_API void *ijsm_dense_get(struct ijsm_dense *self, unsigned handle);
+
+/* moves the last entry into the slot of the removed (swap-remove) */
+IJSM_API int ijsm_dense_remove(struct ijsm_dense *self, unsigned handle);
+
+/* removes all entries of handles that is no longer valid in 'handles',
+ * returns the number of removed entries */
+IJSM_API unsigned ijsm_dense_remove_stale(struct ijsm_dense *self, const struct ijha_h32 *handles);
+
+#define ijsm_dense_contains(self, handle) (ijsm_dense_get((self), (handle)) != 0)
+#define ijsm_dense_size(self) ((self)->map.size)
+#define ijsm_dense_capacity(self) ((self)->map.capacity)
+
+/* iteration of the entries in [0, size) */
+#define ijsm_dense_handle_at(self, dense_index) (*ijha_h32_pointer_add(unsigned *, (self)->entries, (self)->stride * (dense_index)))
+#define ijsm_dense_value_at(value_type, self, dense_index) ijha_h32_pointer_add(value_type, (self)->entries, (self)->stride * (dense_index) + sizeof(unsigned))
+
+#ifdef __cplusplus
+   }
+#endif
+
+#endif /* IJSM_INCLUDED_H */
+
+#if defined(IJSM_TEST_MAIN)
+   #define IJHA_H32_IMPLEMENTATION
+   #define IJSS_IMPLEMENTATION
+   #include "ijha_h32.h"
+   #include "ijss.h"
+#endif
+
+#if defined(IJSM_IMPLEMENTATION) && !defined(IJSM_IMPLEMENTATION_DEFINED)
+
+#define IJSM_IMPLEMENTATION_DEFINED (1)
+
+#ifndef IJSM_assert
+   #include <assert.h>
+   #define IJSM_assert assert
+#endif
+
+IJSM_API void ijsm_paged_init(struct ijsm_paged *self, const struct ijha_h32 *handles, unsigned value_size, void **pages, unsigned num_pages, void *(*allocate_page)(void *user_data, unsigned page_size_in_bytes), void *user_data)
+{
+   unsigned i;
+   IJSM_assert(num_pages >= IJSM_NUM_PAGES(handles->capacity));
+
+   self->pages = pages;
+   self->num_pages = num_pages;
+   self->num_allocated_pages = 0;
+   self->index_mask = handles->capacity_mask;
+   self->stride = IJSM_ENTRY_STRIDE(value_size);
+   self->size = 0;
+   self->allocate_page = allocate_page;
+   self->user_data = user_data;
+   for (i = 0; i != num_pages; ++i)
+      pages[i] = 0;
+}
+
+/* pointer to the entry of the handle index or 0 if the page is not allocated */
+#define ijsm__paged_entry(self, index) ((self)->pages[(index) >> IJSM_PAGE_SHIFT] ? ijha_h32_pointer_add(unsigned *, (self)->pages[(index) >> IJSM_PAGE_SHIFT], (self)->stride * ((index) & (IJSM_PAGE_SIZE - 1))) : (unsigned *)0)
+
+IJSM_API void *ijsm_paged_insert(struct ijsm_paged *self, unsigned handle)
+{
+   unsigned index = handle & self->index_mask;
+   void **page = self->pages + (index >> IJSM_PAGE_SHIFT);
+   unsigned *entry;
+
+   IJSM_assert(handle != 0);
+   IJSM_assert(self->num_pages > (index >> IJSM_PAGE_SHIFT));
+   if (!*page) {
+      unsigned i;
+      void *p = self->allocate_page(self->user_data, self->stride << IJSM_PAGE_SHIFT);
+      if (!p)
+         return 0;
+      /* a valid handle is never 0, marks the entry as empty */
+      for (i = 0; i != IJSM_PAGE_SIZE; ++i)
+         *ijha_h32_pointer_add(unsigned *, p, self->stride * i) = 0;
+      *page = p;
+      ++self->num_allocated_pages;
+   }
+
+   entry = ijha_h32_pointer_add(unsigned *, *page, self->stride * (index & (IJSM_PAGE_SIZE - 1)));
+   if (*entry == 0)
+      ++self->size;
+   *entry = handle;
+   return entry + 1;
+}
+
+IJSM_API void *ijsm_paged_get(struct ijsm_paged *self, unsigned handle)
+{
+   unsigned index = handle & self->index_mask;
+   unsigned *entry;
+   /* an empty entry is 0, as is the handle of a garbage index past the pages */
+   if (handle == 0 || (index >> IJSM_PAGE_SHIFT) >= self->num_pages)
+      return 0;
+   entry = ijsm__paged_entry(self, index);
+   return (entry && *entry == handle) ? entry + 1 : 0;
+}
+
+IJSM_API int ijsm_paged_remove(struct ijsm_paged *self, unsigned handle)
+{
+   unsigned index = handle & self->index_mask;
+   unsigned *entry;
+   if (handle == 0 || (index >> IJSM_PAGE_SHIFT) >= self->num_pages)
+      return 0;
+   entry = ijsm__paged_entry(self, index);
+   if (!entry || *entry != handle)
+      return 0;
+
+   *entry = 0;
+   --self->size;
+   return 1;
+}
+
+IJSM_API unsigned ijsm_dense_memory_size_needed(const struct ijha_h32 *handles, unsigned capacity, unsigned value_size)
+{
+   return capacity * (IJSM_ENTRY_STRIDE(value_size) + sizeof(unsigned)) + handles->capacity * sizeof(unsigned);
+}
+
+IJSM_API void ijsm_dense_init(struct ijsm_dense *self, const struct ijha_h32 *handles, unsigned capacity, unsigned value_size, void *memory)
+{
+   unsigned stride = IJSM_ENTRY_STRIDE(value_size);
+   unsigned *dense = ijha_h32_pointer_add(unsigned *, memory, capacity * stride);
+   unsigned *sparse = dense + capacity;
+
+   self->entries = memory;
+   self->index_mask = handles->capacity_mask;
+   self->stride = stride;
+   /* the sparse side covers all handle indices while the dense side only has room for 'capacity' */
+   ijss_initex(&self->map, dense, sizeof *dense, sparse, sizeof *sparse, sizeof *dense, capacity, handles->capacity);
+}
+
+IJSM_API void ijsm_dense_reset(struct ijsm_dense *self)
+{
+   ijss_reset(&self->map);
+}
+
+IJSM_API void *ijsm_dense_insert(struct ijsm_dense *self, unsigned handle)
+{
+   unsigned index = handle & self->index_mask;
+   unsigned dense_index;
+
+   IJSM_assert(handle != 0);
+   if (ijss_has(&self->map, index)) {
+      dense_index = ijss_dense_index(&self->map, index);
+   } else {
+      if (self->map.size == self->map.capacity)
+         return 0;
+      dense_index = ijss_add(&self->map, index);
+   }
+
+   ijsm_dense_handle_at(self, dense_index) = handle;
+   return ijsm_dense_value_at(void *, self, dense_index);
+}
+
+IJSM_API void *ijsm_dense_get(struct ijsm_dense *self, unsigned handle)
+{
+   unsigned index = handle & self->index_mask;
+   unsigned dense_index;
+   if (!ijss_has(&self->map, index))
+      return 0;
+
+   dense_index = ijss_dense_index(&self->map, index);
+   return ijsm_dense_handle_at(self, dense_index) == handle ? ijsm_dense_value_at(void *, self, dense_index) : 0;
+}
+
+static void ijsm__dense_remove_index(struct ijsm_dense *self, unsigned index)
+{
+   unsigned move_to, move_from, i;
+   if (ijss_remove(&self->map, index, &move_to, &move_from) > 0) {
+      unsigned *to = &ijsm_dense_handle_at(self, move_to), *from = &ijsm_dense_handle_at(self, move_from);
+      for (i = 0; i != self->stride / sizeof(unsigned); ++i)
+         to[i] = from[i];
+   }
+}
+
+IJSM_API int ijsm_dense_remove(struct ijsm_dense *self, unsigned handle)
+{
+   if (!ijsm_dense_get(self, handle))
+      return 0;
+
+   ijsm__dense_remove_index(self, handle & self->index_mask);
+   return 1;
+}
+
+IJSM_API unsigned ijsm_dense_remove_stale(struct ijsm_dense *self, const struct ijha_h32 *handles)
+{
+   unsigned i = 0, num_removed = 0;
+   while (i != self->map.size) {
+      unsigned handle = ijsm_dense_handle_at(self, i);
+      if (ijha_h32_valid(handles, handle)) {
+         ++i;
+      } else {
+         /* the last entry is moved to 'i' and checked next */
+         ijsm__dense_remove_index(self, handle & self->index_mask);
+         ++num_removed;
+      }
+   }
+   return num_removed;
+}
+
+#if defined(IJSM_TEST) || defined(IJSM_TEST_MAIN)
+
+/* hands out consecutive pages of 'memory' until 'num_left' runs out */
+struct ijsm_test_pages {
+   unsigned char *memory;
+   unsigned num_left;
+};
+
+static void *ijsm_test_allocate_page(void *user_data, unsigned page_size_in_bytes)
+{
+   struct ijsm_test_pages *pages = (struct ijsm_test_pages *)user_data;
+   void *page = pages->memory;
+   if (pages->num_left == 0)
+      return 0;
+   --pages->num_left;
+   pages->memory += page_size_in_bytes;
+   return page;
+}
+
+struct ijsm_test_value {
+   unsigned a, b;
+};
+
+static void ijsm_test_paged_dense(void)
+{
+#define IJSM_TEST_MAX_NUM_HANDLES (1000)
+#define IJSM_TEST_DENSE_CAPACITY (200)
+#define IJSM_TEST_NUM_POOL_PAGES IJSM_NUM_PAGES(IJSM_TEST_MAX_NUM_HANDLES)
+   static unsigned handles_memory[IJSM_TEST_MAX_NUM_HANDLES];
+   static unsigned attached[IJSM_TEST_MAX_NUM_HANDLES], stale[IJSM_TEST_MAX_NUM_HANDLES];
+   static unsigned char page_memory[IJSM_TEST_NUM_POOL_PAGES * IJSM_PAGE_SIZE * IJSM_ENTRY_STRIDE(sizeof(struct ijsm_test_value))];
+   static unsigned dense_memory[(IJSM_TEST_DENSE_CAPACITY * (IJSM_ENTRY_STRIDE(sizeof(struct ijsm_test_value)) + sizeof(unsigned)) + IJSM_TEST_MAX_NUM_HANDLES * sizeof(unsigned)) / sizeof(unsigned)];
+   void *page_table[IJSM_NUM_PAGES(IJSM_TEST_MAX_NUM_HANDLES)], *page_table_no_pages[IJSM_NUM_PAGES(IJSM_TEST_MAX_NUM_HANDLES)];
+   struct ijsm_test_pages test_pages;
+   struct ijha_h32 handles;
+   struct ijsm_paged paged, paged_no_pages;
+   struct ijsm_dense dense;
+   unsigned i, round, num_attached = 0, rnd = 1234;
+
+   IJSM_assert(ijha_h32_init_no_inlinehandles(&handles, IJSM_TEST_MAX_NUM_HANDLES, 0, 0, IJHA_H32_INIT_LIFO, handles_memory) == IJHA_H32_INIT_NO_ERROR);
+
+   test_pages.memory = page_memory;
+   test_pages.num_left = IJSM_TEST_NUM_POOL_PAGES;
+   ijsm_paged_init(&paged, &handles, sizeof(struct ijsm_test_value), page_table, IJSM_NUM_PAGES(IJSM_TEST_MAX_NUM_HANDLES), ijsm_test_allocate_page, &test_pages);
+
+   IJSM_assert(ijsm_dense_memory_size_needed(&handles, IJSM_TEST_DENSE_CAPACITY, sizeof(struct ijsm_test_value)) == sizeof dense_memory);
+   ijsm_dense_init(&dense, &handles, IJSM_TEST_DENSE_CAPACITY, sizeof(struct ijsm_test_value), dense_memory);
+
+   for (i = 0; i != IJSM_TEST_MAX_NUM_HANDLES; ++i) {
+      attached[i] = 0;
+      stale[i] = 0;
+   }
+
+   for (round = 0; round != 20000; ++round) {
+      unsigned index, handle;
+      rnd = rnd * 1103515245u + 12345u;
+      index = (rnd >> 8) % IJSM_TEST_MAX_NUM_HANDLES;
+
+      if (!ijha_h32_in_use_index(&handles, index)) {
+         IJSM_assert(ijha_h32_acquire(&handles, &handle) != IJHA_H32_INVALID_INDEX);
+         continue;
+      }
+
+      handle = *ijha_h32_handle_info_at(&handles, index);
+      switch ((rnd >> 24) & 3) {
+         case 0: { /* attach */
+            struct ijsm_test_value *pv, *dv;
+            if (attached[index] == 0 && num_attached == IJSM_TEST_DENSE_CAPACITY)
+               break;
+            pv = (struct ijsm_test_value *)ijsm_paged_insert(&paged, handle);
+            dv = (struct ijsm_test_value *)ijsm_dense_insert(&dense, handle);
+            IJSM_assert(pv && dv);
+            pv->a = dv->a = handle;
+            pv->b = dv->b = ~handle;
+            if (attached[index] == 0)
+               ++num_attached;
+            attached[index] = handle;
+         } break;
+         case 1: { /* detach */
+            int removed = attached[index] == handle;
+            IJSM_assert(ijsm_paged_remove(&paged, handle) == removed);
+            IJSM_assert(ijsm_dense_remove(&dense, handle) == removed);
+            IJSM_assert(!ijsm_paged_contains(&paged, handle) && !ijsm_dense_contains(&dense, handle));
+            if (removed) {
+               attached[index] = 0;
+               --num_attached;
+            }
+         } break;
+         default: { /* release the handle, the entry becomes stale */
+            stale[index] = handle;
+            IJSM_assert(ijha_h32_release(&handles, handle) == index);
+         } break;
+      }
+
+      if ((round & 127) == 0) {
+         for (i = 0; i != IJSM_TEST_MAX_NUM_HANDLES; ++i) {
+            struct ijsm_test_value *pv, *dv;
+            if (stale[i]) {
+               /* found by the released handle until replaced */
+               IJSM_assert((ijsm_paged_get(&paged, stale[i]) != 0) == (attached[i] == stale[i]));
+               IJSM_assert((ijsm_dense_get(&dense, stale[i]) != 0) == (attached[i] == stale[i]));
+            }
+            if (!ijha_h32_in_use_index(&handles, i))
+               continue;
+            handle = *ijha_h32_handle_info_at(&handles, i);
+            pv = (struct ijsm_test_value *)ijsm_paged_get(&paged, handle);
+            dv = (struct ijsm_test_value *)ijsm_dense_get(&dense, handle);
+            IJSM_assert((pv != 0) == (attached[i] == handle) && (dv != 0) == (attached[i] == handle));
+            IJSM_assert(!pv || (pv->a == handle && pv->b == ~handle));
+            IJSM_assert(!dv || (dv->a == handle && dv->b == ~handle));
+         }
+         IJSM_assert(paged.size == num_attached && ijsm_dense_size(&dense) == num_attached);
+         for (i = 0; i != ijsm_dense_size(&dense); ++i)
+            IJSM_assert(ijsm_dense_value_at(struct ijsm_test_value *, &dense, i)->a == ijsm_dense_handle_at(&dense, i));
+      }
+   }
+
+   /* purge the stale entries of the dense map */
+   {
+      unsigned num_stale = 0;
+      for (i = 0; i != IJSM_TEST_MAX_NUM_HANDLES; ++i) {
+         if (attached[i] && !ijha_h32_valid(&handles, attached[i]))
+            ++num_stale;
+      }
+      IJSM_assert(ijsm_dense_remove_stale(&dense, &handles) == num_stale);
+      IJSM_assert(ijsm_dense_size(&dense) == num_attached - num_stale);
+      for (i = 0; i != ijsm_dense_size(&dense); ++i)
+         IJSM_assert(ijha_h32_valid(&handles, ijsm_dense_handle_at(&dense, i)));
+   }
+
+   /* out of pages */
+   test_pages.num_left = 0;
+   ijsm_paged_init(&paged_no_pages, &handles, sizeof(struct ijsm_test_value), page_table_no_pages, IJSM_NUM_PAGES(IJSM_TEST_MAX_NUM_HANDLES), ijsm_test_allocate_page, &test_pages);
+   for (i = 0; i != IJSM_TEST_MAX_NUM_HANDLES; ++i) {
+      if (ijha_h32_in_use_index(&handles, i)) {
+         IJSM_assert(ijsm_paged_insert(&paged_no_pages, *ijha_h32_handle_info_at(&handles, i)) == 0);
+         IJSM_assert(!ijsm_paged_contains(&paged_no_pages, *ijha_h32_handle_info_at(&handles, i)));
+      }
+   }
+   IJSM_assert(paged_no_pages.size == 0 && paged_no_pages.num_allocated_pages == 0);
+#undef IJSM_TEST_MAX_NUM_HANDLES
+#undef IJSM_TEST_DENSE_CAPACITY
+#undef IJSM_TEST_NUM_POOL_PAGES
+}
+
+static void ijsm_test_paged_invalid_handles(void)
+{
+#define IJSM_TEST_MAX_NUM_HANDLES (513)
+   static unsigned handles_memory[IJSM_TEST_MAX_NUM_HANDLES];
+   static unsigned char page_memory[IJSM_NUM_PAGES(IJSM_TEST_MAX_NUM_HANDLES) * IJSM_PAGE_SIZE * IJSM_ENTRY_STRIDE(sizeof(unsigned))];
+   void *page_table[IJSM_NUM_PAGES(IJSM_TEST_MAX_NUM_HANDLES)];
+   struct ijsm_test_pages test_pages;
+   struct ijha_h32 handles;
+   struct ijsm_paged paged;
+   unsigned index, handle, garbage;
+
+   IJSM_assert(ijha_h32_init_no_inlinehandles(&handles, IJSM_TEST_MAX_NUM_HANDLES, 0, 0, IJHA_H32_INIT_LIFO, handles_memory) == IJHA_H32_INIT_NO_ERROR);
+   test_pages.memory = page_memory;
+   test_pages.num_left = IJSM_NUM_PAGES(IJSM_TEST_MAX_NUM_HANDLES);
+   ijsm_paged_init(&paged, &handles, sizeof(unsigned), page_table, IJSM_NUM_PAGES(IJSM_TEST_MAX_NUM_HANDLES), ijsm_test_allocate_page, &test_pages);
+
+   /* the empty entries of an allocated page is 0, which must not match handle 0 */
+   do {
+      index = ijha_h32_acquire(&handles, &handle);
+   } while (index == 0 || index >= IJSM_PAGE_SIZE);
+   IJSM_assert(ijsm_paged_insert(&paged, handle) != 0 && page_table[0] != 0);
+   IJSM_assert(!ijsm_paged_contains(&paged, 0) && ijsm_paged_get(&paged, 0) == 0);
+   IJSM_assert(ijsm_paged_remove(&paged, 0) == 0 && paged.size == 1);
+
+   /* the index mask covers more than the pages, a garbage handle past them is not present */
+   garbage = 0x80000000u | handles.capacity_mask;
+   IJSM_assert((garbage & handles.capacity_mask) >> IJSM_PAGE_SHIFT >= paged.num_pages);
+   IJSM_assert(ijsm_paged_get(&paged, garbage) == 0 && !ijsm_paged_contains(&paged, garbage));
+   IJSM_assert(ijsm_paged_remove(&paged, garbage) == 0 && paged.size == 1);
+#undef IJSM_TEST_MAX_NUM_HANDLES
+}
+
+static void ijsm_test_suite(void)
+{
+   ijsm_test_paged_dense();
+   ijsm_test_paged_invalid_handles();
+}
+
+#if defined(IJSM_TEST_MAIN)
+
+#include <stdio.h>
+
+int main(int args, char **argc)
+{
+   (void)args;
+   (void)argc;
+   ijsm_test_suite();
+   printf("ijsm: all tests done.\n");
+   return 0;
+}
+#endif
+
+#endif /* defined(IJSM_TEST) || defined(IJSM_TEST_MAIN) */
+#endif /* defined(IJSM_IMPLEMENTATION) */
+
+/*
+LICENSE
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - 3-Clause BSD License
+Copyright (c) 2019-, Fredrik Engkvist
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the copyright holder nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+software, either in source code form or as a compiled binary, for any purpose,
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this
+software dedicate any and all copyright interest in the software to the public
+domain. We make this dedication for the benefit of the public at large and to
+the detriment of our heirs and successors. We intend this dedication to be an
+overt act of relinquishment in perpetuity of all present and future rights to
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
+/* clang-format on */
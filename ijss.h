@@ -41,6 +41,14 @@ References:
    #define IJSS_API extern
 #endif
 
+#ifdef _MSC_VER
+   typedef unsigned __int64 ijss_uint64;
+#elif defined(__GNUC__)
+   __extension__ typedef unsigned long long ijss_uint64;
+#else
+   typedef unsigned long long ijss_uint64;
+#endif
+
 struct ijss_pair8 {
    unsigned char sparse_index;
    unsigned char dense_index;
@@ -56,17 +64,47 @@ struct ijss_pair32 {
    unsigned dense_index;
 };
 
+struct ijss_pair64 {
+   ijss_uint64 sparse_index;
+   ijss_uint64 dense_index;
+};
+
 struct ijss {
    void *dense;
-   void *sparse;
+   void *sparse; /* or a 'struct ijss_sparse_pages' if IJSS_FLAGS_PAGED_SPARSE is set */
    unsigned dense_stride;
    unsigned sparse_stride;
    unsigned size;
    unsigned capacity;
    unsigned elementsize; /* size in bytes for _one_ dense/sparse index */
+   unsigned flags;
+   unsigned sparse_capacity; /* sparse indices is in [0, sparse_capacity), same as capacity unless paged (or see 'ijss_initex') */
    unsigned reserved32;
 };
 
+#define IJSS_FLAGS_PAGED_SPARSE (1u << 0)
+
+#define IJSS_INVALID_INDEX (0xffffffffu)
+
+/* number of sparse indices per page (a power of 2) for paged sparse sets */
+#ifndef IJSS_SPARSE_PAGE_SHIFT
+   #define IJSS_SPARSE_PAGE_SHIFT (12)
+#endif
+#define IJSS_SPARSE_PAGE_SIZE (1u << IJSS_SPARSE_PAGE_SHIFT)
+
+/* page table for the sparse side of a paged sparse set, see 'ijss_init_paged' */
+struct ijss_sparse_pages {
+   void **pages; /* 'num_pages' entries */
+   unsigned num_pages;
+   unsigned num_allocated_pages;
+   /* called when a sparse index on a page not yet allocated is added, must
+    * return 'page_size_in_bytes' of memory (the contents does not matter) or
+    * null on failure. a page is IJSS_SPARSE_PAGE_SIZE dense indices of
+    * 'elementsize' bytes, or 4 bytes for elementsize 8 */
+   void *(*allocate_page)(void *user_data, unsigned page_size_in_bytes);
+   void *user_data;
+};
+
 
 /* dense: pointer to storage of dense indices
  * dense_stride: how many bytes to advance from index A to A+1
@@ -74,7 +112,7 @@ struct ijss {
  * sparse+sparse_index: same as dense above but for sparse indices
  *
  * elementsize:
- *    the size in bytes of _one_ sparse/dense _index_
+ *    the size in bytes of _one_ sparse/dense _index_ (1, 2, 4 or 8)
  *    i.e. if using ijss_pairXX for bookkeeping use 'sizeof(struct ijss_pairXX)>>1'
  *
  * capacity: how many dense/sparse pairs to manage
@@ -84,6 +122,41 @@ struct ijss {
  */
 IJSS_API void ijss_init(struct ijss *self, void *dense, unsigned dense_stride, void *sparse, unsigned sparse_stride, unsigned elementsize, unsigned capacity);
 
+/* same as 'ijss_init' but with a flat sparse side of 'sparse_capacity' entries,
+ * i.e. sparse indices is in [0, sparse_capacity) while the dense side has room
+ * for 'capacity' (ex: a set keyed by handle indices with fewer members) */
+IJSS_API void ijss_initex(struct ijss *self, void *dense, unsigned dense_stride, void *sparse, unsigned sparse_stride, unsigned elementsize, unsigned capacity, unsigned sparse_capacity);
+
+/* initialize a sparse set where the sparse side is a page table of fixed size
+ * pages (IJSS_SPARSE_PAGE_SIZE sparse indices each) which is allocated on demand
+ * when a sparse index is added, which is useful when the sparse index space
+ * is much larger than the number of members.
+ *
+ * the caller sets up 'pages', 'num_pages', 'allocate_page' and 'user_data' of
+ * 'sparse_pages' before the call. all pages then refers to a shared read-only
+ * empty page (see 'ijss_sparse_empty_page') until allocated.
+ * sparse indices is in [0, num_pages*IJSS_SPARSE_PAGE_SIZE) and must be
+ * representable with 'elementsize' bytes.
+ *
+ * pages is never freed by the sparse set, the ones not equal to the empty page
+ * is owned by the caller.
+ *
+ * ex:
+ *    void *page_table[4096]; // 16M sparse indices
+ *    struct ijss_sparse_pages sparse_pages = { page_table, 4096, 0, my_allocate_page, 0 };
+ *    unsigned dense_indices[1024];
+ *    struct ijss sparse_set;
+ *    ijss_init_paged(&sparse_set, dense_indices, sizeof *dense_indices, &sparse_pages, sizeof *dense_indices, 1024);
+ */
+IJSS_API void ijss_init_paged(struct ijss *self, void *dense, unsigned dense_stride, struct ijss_sparse_pages *sparse_pages, unsigned elementsize, unsigned capacity);
+
+/* the shared read-only page that unallocated pages refers to */
+IJSS_API const void *ijss_sparse_empty_page(void);
+
+/* makes sure the page of 'sparse_index' is allocated (always succeeds for non
+ * paged sets), returns 0 if the allocation failed */
+IJSS_API int ijss_sparse_page_reserve(struct ijss *self, unsigned sparse_index);
+
 /* initialize sparse set with a pair (ex struct ijss_pair<NBITS>) size (size of the _pair_) */
 #define ijss_init_from_pairtype_size(pairtype_size, self, pairs, stride, capacity) ijss_init((self), (unsigned char*)(pairs), (stride), (unsigned char*)(pairs)+((pairtype_size)>>1), (stride), (pairtype_size)>>1, capacity)
 
@@ -120,7 +193,8 @@ IJSS_API void ijss_reset(struct ijss *self);
 /* reset and sets to D[x] = x for x [0, capacity) */
 IJSS_API void ijss_reset_identity(struct ijss *self);
 
-/* returns the dense index */
+/* returns the dense index (or IJSS_INVALID_INDEX if the page for a paged sparse
+ * set could not be allocated) */
 IJSS_API unsigned ijss_add(struct ijss *self, unsigned sparse_index);
 
 /* returns -1 on invalid sparse index else if a move of (external) data is needed
@@ -138,6 +212,538 @@ IJSS_API unsigned ijss_dense_index(struct ijss *self, unsigned sparse_index);
 IJSS_API unsigned ijss_sparse_index(struct ijss *self, unsigned dense_index);
 IJSS_API int ijss_has(struct ijss *self, unsigned sparse_index);
 
+/* a move of (external) dense data, i.e. my_external_data[to_index] = my_external_data[from_index] */
+struct ijss_move {
+   unsigned to_index;
+   unsigned from_index;
+};
+
+/* adds 'n' sparse indices, none of which may already be in the set.
+ * returns the dense index of the first, the rest follows consecutively
+ * (or IJSS_INVALID_INDEX and none is added if a page could not be allocated) */
+IJSS_API unsigned ijss_add_n(struct ijss *self, const unsigned *sparse_indices, unsigned n);
+
+/* removes 'n' sparse indices (the ones not in the set, or duplicates, is ignored)
+ * and stores the moves of (external) dense data that is needed in 'moves_out'
+ * returning the number of moves.
+ *
+ * the moves is the minimal set, i.e. elements at the back that is also removed
+ * is never moved, and the moves can be applied in any order.
+ *
+ * 'moves_out' must have room for 'n' moves (it is also used as scratch memory)
+ *
+ * ex:
+ *    unsigned i, num_moves = ijss_remove_n(self, indices, n, moves);
+ *    for (i = 0; i != num_moves; ++i)
+ *       my_external_data[moves[i].to_index] = my_external_data[moves[i].from_index];
+ */
+IJSS_API unsigned ijss_remove_n(struct ijss *self, const unsigned *sparse_indices, unsigned n, struct ijss_move *moves_out);
+
+/* batch version of 'ijss_has' that tests 'n' sparse indices (out of range ones
+ * is allowed and reported as not in the set).
+ * stores the result as a bitmask in 'mask_out', bit (i&31) of mask_out[i>>5] is
+ * set if sparse_indices[i] is in the set, i.e. 'mask_out' must have room for
+ * (n+31)/32 words. returns the number of sparse indices in the set.
+ *
+ * when compiled with AVX2 enabled (and IJSS_NO_SIMD not defined) 16-bit and
+ * 32-bit elementsizes is tested 8 at a time using gathers */
+IJSS_API unsigned ijss_has_n(struct ijss *self, const unsigned *sparse_indices, unsigned n, unsigned *mask_out);
+
+/* same as 'ijss_has_n' but stores the dense index of sparse_indices[i] in
+ * dense_out[i] (or IJSS_INVALID_INDEX if not in the set) */
+IJSS_API unsigned ijss_dense_index_n(struct ijss *self, const unsigned *sparse_indices, unsigned n, unsigned *dense_out);
+
+#ifndef IJSS_JOIN_MAX_SETS
+   #define IJSS_JOIN_MAX_SETS (8)
+#endif
+
+#ifndef IJSS_JOIN_BATCH_SIZE
+   #define IJSS_JOIN_BATCH_SIZE (64)
+#endif
+
+/* join (intersection) iterator over several sparse sets.
+ *
+ * the smallest set drives the iteration (in dense order) and the membership in
+ * the rest is tested a batch at a time (see 'ijss_dense_index_n').
+ * the sets must not be modified while iterating.
+ *
+ * ex: (all with Position and Velocity)
+ *    struct ijss *sets[2] = { &ss_positions, &ss_velocities };
+ *    struct ijss_join join;
+ *    unsigned i, n;
+ *    ijss_join_init(&join, sets, 2);
+ *    while ((n = ijss_join_next_batch(&join)) != 0) {
+ *       for (i = 0; i != n; ++i)
+ *          integrate(&positions[join.dense_indices[0][i]], &velocities[join.dense_indices[1][i]]);
+ *    }
+ */
+struct ijss_join {
+   struct ijss *sets[IJSS_JOIN_MAX_SETS];
+   unsigned num_sets;
+   unsigned driver; /* index (in 'sets') of the smallest set */
+   unsigned position; /* next dense index of the driver to test */
+   unsigned count; /* number of matches in the current batch */
+   unsigned cursor; /* next match in the current batch to yield by 'ijss_join_next' */
+   /* matches in the current batch, dense_indices[set][i] is the dense index in 'sets[set]' for sparse_indices[i] */
+   unsigned sparse_indices[IJSS_JOIN_BATCH_SIZE];
+   unsigned dense_indices[IJSS_JOIN_MAX_SETS][IJSS_JOIN_BATCH_SIZE];
+};
+
+/* 'num_sets' must be in [1, IJSS_JOIN_MAX_SETS] */
+IJSS_API void ijss_join_init(struct ijss_join *self, struct ijss * const *sets, unsigned num_sets);
+
+/* fills the next batch of matches in self->sparse_indices/self->dense_indices,
+ * returns the number of matches or 0 when done */
+IJSS_API unsigned ijss_join_next_batch(struct ijss_join *self);
+
+/* one match at a time (uses 'ijss_join_next_batch'), stores the dense index per
+ * set in 'dense_indices_out' (room for 'num_sets').
+ * returns 0 when done. 'sparse_index_out' is optional (may be null) */
+IJSS_API int ijss_join_next(struct ijss_join *self, unsigned *sparse_index_out, unsigned *dense_indices_out);
+
+/* swaps the position of two dense indices, i.e. the (external) dense data
+ * should be swapped as well (my_external_data[dense_index_a] <-> my_external_data[dense_index_b]) */
+IJSS_API void ijss_swap(struct ijss *self, unsigned dense_index_a, unsigned dense_index_b);
+
+#ifndef IJSS_GROUP_MAX_SETS
+   #define IJSS_GROUP_MAX_SETS IJSS_JOIN_MAX_SETS
+#endif
+
+/* owning group over several sparse sets.
+ *
+ * keeps the sparse indices that is in all sets in a common prefix [0, size) of
+ * every set's dense array, at the same position in all of them, i.e. the
+ * (external) dense data of the group members can be iterated linearly:
+ *
+ *    for (i = 0; i != group.size; ++i)
+ *       integrate(&positions[i], &velocities[i]);
+ *
+ * the group is maintained by calling 'ijss_group_on_add' after a sparse index
+ * is added to one of the sets and 'ijss_group_on_remove' before it is removed
+ * from one of them. both stores a swap of (external) dense data per set in
+ * 'swaps_out' (room for 'num_sets'), swap my_external_data[to_index] and
+ * my_external_data[from_index] of the respective set (to_index == from_index
+ * is a no-op).
+ *
+ * ex:
+ *    struct ijss_move swaps[2];
+ *    unsigned dense_index = ijss_add(&ss_velocities, entity);
+ *    velocities[dense_index] = v;
+ *    if (ijss_group_on_add(&group, entity, swaps)) {
+ *       swap(positions, swaps[0].to_index, swaps[0].from_index);
+ *       swap(velocities, swaps[1].to_index, swaps[1].from_index);
+ *    }
+ *
+ * a sparse set can be owned by at most one group */
+struct ijss_group {
+   struct ijss *sets[IJSS_GROUP_MAX_SETS];
+   unsigned num_sets;
+   unsigned size;
+};
+
+/* initializes an empty group, if the sets already have members in common call
+ * 'ijss_group_on_add' for each sparse index of (the smallest) one of the sets. */
+IJSS_API void ijss_group_init(struct ijss_group *self, struct ijss * const *sets, unsigned num_sets);
+
+/* returns 1 if 'sparse_index' joined the group (swaps_out is valid) else 0 */
+IJSS_API int ijss_group_on_add(struct ijss_group *self, unsigned sparse_index, struct ijss_move *swaps_out);
+
+/* returns 1 if 'sparse_index' left the group (swaps_out is valid) else 0 */
+IJSS_API int ijss_group_on_remove(struct ijss_group *self, unsigned sparse_index, struct ijss_move *swaps_out);
+
+/* returns 1 if 'sparse_index' is a member of the group */
+IJSS_API int ijss_group_has(struct ijss_group *self, unsigned sparse_index);
+
+/* (re)builds the set from 'n' distinct sparse indices in O(n), i.e. the set
+ * is reset and sparse_indices[i] gets dense index 'i'. the dense side is a
+ * straight copy (using non-temporal stores for large, packed 4 byte dense
+ * arrays if SSE2 is available) and the sparse side a single scatter pass.
+ * returns 0 (and leaves the set empty) if a page of a paged sparse set could
+ * not be allocated */
+IJSS_API int ijss_build(struct ijss *self, const unsigned *sparse_indices, unsigned n);
+
+/* number of elements from which 'ijss_build' uses non-temporal stores */
+#ifndef IJSS_BUILD_STREAM_THRESHOLD
+   #define IJSS_BUILD_STREAM_THRESHOLD (1u << 16)
+#endif
+
+/* serialization of a set (elementsize 1, 2 or 4), only the size and the dense
+ * side is stored, the sparse side is rebuilt when loaded.
+ *
+ * format: [flags:1][elementsize:1][size:4 little endian] followed by the dense
+ * side as 'elementsize' bytes little endian per element, or if
+ * IJSS_SERIALIZE_DELTA_VARINT is used, the (zigzag) delta from the previous
+ * sparse index as a LEB128 varint (small after sorting, see 'ijss_sort').
+ * tombstones (see 'ijss_remove_deferred') is not written, the elements after
+ * one is loaded at a dense index shifted down by one per tombstone before it */
+#define IJSS_SERIALIZE_DELTA_VARINT (1u << 0)
+#define IJSS_SERIALIZE_HEADER_SIZE (6)
+/* upper bound of the serialized size of a set of 'size' */
+#define IJSS_SERIALIZE_MAX_SIZE(size) (IJSS_SERIALIZE_HEADER_SIZE + 5 * (size))
+
+/* writes the set to 'buffer' and returns the number of bytes written, or if
+ * 'buffer' is null (or too small) returns the number of bytes needed */
+IJSS_API unsigned ijss_serialize(struct ijss *self, unsigned flags, void *buffer, unsigned buffer_size);
+
+/* loads the set (which must be initialized) from 'buffer', returns the number
+ * of bytes read or 0 (and leaves the set empty) if the data is invalid for the
+ * set, i.e. corrupt, too many elements, a sparse index out of range or
+ * duplicated, or a page of a paged sparse set could not be allocated */
+IJSS_API unsigned ijss_deserialize(struct ijss *self, const void *buffer, unsigned buffer_size);
+
+/* number of unsigned of scratch memory 'ijss_sort' needs for a set of 'size' */
+#define IJSS_SORT_SCRATCH_COUNT(size) (3 * (size))
+
+/* sorts the dense array (stable, radix sort) by sparse index if 'keys' is null
+ * else by keys[dense_index] (ex: a key column of the (external) dense data) and
+ * fixes up the sparse side.
+ *
+ * stores the permutation in 'permutation_out' (room for 'size'), the element
+ * at dense index 'i' came from dense index permutation_out[i], i.e. (external)
+ * dense data is reordered in one pass by:
+ *
+ *    for (i = 0; i != sparse_set.size; ++i)
+ *       my_sorted_external_data[i] = my_external_data[permutation_out[i]];
+ *
+ * 'scratch' must have room for IJSS_SORT_SCRATCH_COUNT(size) unsigned */
+IJSS_API void ijss_sort(struct ijss *self, const unsigned *keys, unsigned *permutation_out, unsigned *scratch);
+
+/* state of an incremental sort (see 'ijss_sort_incremental'), zero initialize.
+ * [0, sorted_end) is sorted and the element being inserted is at 'position' */
+struct ijss_sort_state {
+   unsigned sorted_end;
+   unsigned position;
+};
+
+/* incremental (insertion) sort, by sparse index if 'keys' is null else by
+ * keys[dense_index], that does at most 'max_compares' key compares per call,
+ * i.e. the work of restoring dense order can be spread over several frames.
+ *
+ * every swap is of adjacent elements and is stored in 'swaps_out' (room for
+ * 'max_compares'), swap my_external_data[to_index] and my_external_data[from_index]
+ * in order. 'keys' (if any) is swapped along.
+ * returns the number of swaps.
+ *
+ * state->sorted_end == size after a call means the set is sorted (if the set
+ * was not modified during the pass), the next call then starts a new pass.
+ * the set can be modified in between calls, which only delays the sorting.
+ *
+ * ex: (once per frame)
+ *    unsigned i, num_swaps = ijss_sort_incremental(&sparse_set, &sort_state, 0, 256, swaps);
+ *    for (i = 0; i != num_swaps; ++i)
+ *       swap(my_external_data, swaps[i].to_index, swaps[i].from_index);
+ */
+IJSS_API unsigned ijss_sort_incremental(struct ijss *self, struct ijss_sort_state *state, unsigned *keys, unsigned max_compares, struct ijss_move *swaps_out);
+
+/* deferred removal, the sparse index is no longer in the set (ijss_has returns
+ * false) but the dense slot is left as a tombstone until 'ijss_compact', i.e.
+ * no data is moved and the dense array can be modified while iterating:
+ *
+ *    for (i = 0; i != sparse_set.size; ++i) {
+ *       if (ijss_is_tombstone(&sparse_set, i))
+ *          continue;
+ *       if (should_die(&my_external_data[i]))
+ *          ijss_remove_deferred(&sparse_set, ijss_sparse_index(&sparse_set, i));
+ *    }
+ *    num_moves = ijss_compact(&sparse_set, moves);
+ *
+ * returns 1 if the sparse index was in the set.
+ * tombstones stays tombstones when moved by 'ijss_swap', 'ijss_sort' and
+ * 'ijss_sort_incremental' (and so the groups and partitions), they are skipped
+ * by 'ijss_join_*' and 'ijss_serialize' and never found by 'ijss_has_n' and
+ * 'ijss_dense_index_n'. a removed sparse index can be added again, the old slot
+ * is still a tombstone.
+ * NB: 'ijss_remove'/'ijss_remove_n' must not be used while there is tombstones,
+ *     a tombstone counts as a member of the group or partition it is in and
+ *     'ijss_compact' does not update groups or partitions */
+IJSS_API int ijss_remove_deferred(struct ijss *self, unsigned sparse_index);
+
+/* returns 1 if the dense index is a tombstone (see 'ijss_remove_deferred') */
+IJSS_API int ijss_is_tombstone(struct ijss *self, unsigned dense_index);
+
+/* closes the holes left by 'ijss_remove_deferred' by moving elements from the
+ * back, storing the moves of (external) dense data in 'moves_out' (room for
+ * the number of deferred removals), returns the number of moves.
+ * as with 'ijss_remove_n' the moves is minimal and can be applied in any order,
+ * and the removed sparse indices is kept at the back (in [size, old size)) */
+IJSS_API unsigned ijss_compact(struct ijss *self, struct ijss_move *moves_out);
+
+#if !defined(IJSS_NO_THREADSAFE_SUPPORT)
+   #define IJSS_HAS_ATOMICS (1)
+#endif
+
+/* thread safe adds of _distinct_ sparse indices (which must not be in the set)
+ * from several threads at once, dense slots is reserved with a compare and swap
+ * on 'size' and then written (no other operation may run concurrently).
+ *
+ * 'ijss_reserve_ts' reserves 'n' consecutive dense slots and returns the first
+ * (or IJSS_INVALID_INDEX if fewer than 'n' slots is left, 'size' never exceeds
+ * the capacity), 'ijss_set_pair' then writes the dense/sparse pair of a reserved
+ * slot.
+ *
+ * ex: (bulk spawn from a job)
+ *    unsigned i, first = ijss_reserve_ts(&sparse_set, n);
+ *    for (i = 0; i != n; ++i)
+ *       ijss_set_pair(&sparse_set, first + i, my_entities[i]);
+ *
+ * NB: not available for paged sparse sets (pages would be allocated concurrently)
+ * and only if compiled with atomics support (IJSS_HAS_ATOMICS) */
+#if IJSS_HAS_ATOMICS
+IJSS_API unsigned ijss_reserve_ts(struct ijss *self, unsigned n);
+IJSS_API unsigned ijss_add_ts(struct ijss *self, unsigned sparse_index);
+#endif
+IJSS_API void ijss_set_pair(struct ijss *self, unsigned dense_index, unsigned sparse_index);
+
+#ifndef IJSS_CACHE_LINE_SIZE
+   #define IJSS_CACHE_LINE_SIZE (64)
+#endif
+
+/* processes the dense indices [begin, end) */
+typedef void (*ijss_range_func)(void *user_data, unsigned begin, unsigned end);
+
+/* thread pool hook, runs task(task_data, i) for i in [0, num_tasks) (in any
+ * order, possibly in parallel) and returns when all is done */
+typedef void (*ijss_dispatch_func)(void *pool, void (*task)(void *task_data, unsigned task_index), void *task_data, unsigned num_tasks);
+
+/* returns a chunk size (number of dense indices, at least 'min_chunk_size')
+ * where all chunk boundaries is cache line aligned in every (external) column
+ * with the given byte strides as well as the dense arrays of 'sets' (may be
+ * null), i.e. no two chunks writes to the same cache line.
+ * (assumes the columns starts at a cache line boundary) */
+IJSS_API unsigned ijss_chunk_size(struct ijss * const *sets, unsigned num_sets, const unsigned *column_strides, unsigned num_columns, unsigned min_chunk_size);
+
+/* splits [0, count) in chunks of 'chunk_size' and calls 'func' for each through
+ * 'dispatch' (or serially on the calling thread if 'dispatch' is null).
+ *
+ * ex: (a set, or the common prefix of an owning group using group.size and group.sets)
+ *    unsigned strides[2] = { sizeof(struct position), sizeof(struct velocity) };
+ *    unsigned chunk_size = ijss_chunk_size(&set_pointer, 1, strides, 2, 256);
+ *    ijss_parallel_for(set.size, chunk_size, integrate_range, &world, my_pool_dispatch, my_pool);
+ */
+IJSS_API void ijss_parallel_for(unsigned count, unsigned chunk_size, ijss_range_func func, void *user_data, ijss_dispatch_func dispatch, void *pool);
+
+/* number of dense elements per coarse version block (as a shift) */
+#ifndef IJSS_VERSIONS_BLOCK_SHIFT
+   #define IJSS_VERSIONS_BLOCK_SHIFT (6)
+#endif
+#define IJSS_VERSIONS_NUM_BLOCKS(capacity) (((capacity) + (1u << IJSS_VERSIONS_BLOCK_SHIFT) - 1) >> IJSS_VERSIONS_BLOCK_SHIFT)
+
+/* change tracking of the dense elements of a sparse set.
+ *
+ * every dense element has the version of when it was last touched (moved
+ * along with it) and every block of 1<<IJSS_VERSIONS_BLOCK_SHIFT dense
+ * elements has the highest version in it, so unchanged blocks is skipped when
+ * looking for changes.
+ *
+ * ex:
+ *    ijss_touch(&versions, ijss_dense_index(&sparse_set, entity));
+ *    ...
+ *    // replicate what changed since last time
+ *    for (i = ijss_next_changed(&sparse_set, &versions, 0, since); i != sparse_set.size; i = ijss_next_changed(&sparse_set, &versions, i + 1, since))
+ *       replicate(&my_external_data[i]);
+ *    since = ijss_versions_advance(&versions);
+ *
+ * NB: the versions is 32-bit and is not expected to wrap */
+struct ijss_versions {
+   unsigned *versions; /* 'capacity' entries, per dense element */
+   unsigned *block_versions; /* IJSS_VERSIONS_NUM_BLOCKS(capacity) entries */
+   unsigned version; /* current version that touches is stamped with, starts at 1 */
+   unsigned capacity;
+};
+
+IJSS_API void ijss_versions_init(struct ijss_versions *self, unsigned *versions, unsigned *block_versions, unsigned capacity);
+
+/* starts a new version and returns it */
+IJSS_API unsigned ijss_versions_advance(struct ijss_versions *self);
+
+/* marks a dense element as changed in the current version */
+IJSS_API void ijss_touch(struct ijss_versions *self, unsigned dense_index);
+
+/* keeps the versions in sync with moves/swaps of (external) dense data
+ * (ex: the ones reported by 'ijss_remove_n', 'ijss_sort', 'ijss_compact', ...) */
+IJSS_API void ijss_versions_move(struct ijss_versions *self, unsigned to_index, unsigned from_index);
+IJSS_API void ijss_versions_swap(struct ijss_versions *self, unsigned dense_index_a, unsigned dense_index_b);
+
+/* 'ijss_add' that touches the added and 'ijss_remove' that moves the version along */
+IJSS_API unsigned ijss_add_versioned(struct ijss *self, struct ijss_versions *versions, unsigned sparse_index);
+IJSS_API int ijss_remove_versioned(struct ijss *self, struct ijss_versions *versions, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index);
+
+/* returns the first dense index >= 'dense_index' touched in version 'since'
+ * or later, or the size of the set if none */
+IJSS_API unsigned ijss_next_changed(struct ijss *self, struct ijss_versions *versions, unsigned dense_index, unsigned since);
+
+#ifndef IJSS_COLUMNS_MAX
+   #define IJSS_COLUMNS_MAX (16)
+#endif
+
+/* an (external) dense data column, element 'i' is at base+i*stride */
+struct ijss_column {
+   void *base;
+   unsigned element_size;
+   unsigned stride;
+};
+
+/* registry of (external) dense data columns of a sparse set that is moved
+ * along by the 'ijss_columns_*' versions of the operations, i.e. no manual
+ * my_external_data[move_to] = my_external_data[move_from] is needed.
+ * copies is specialized for elements of 1, 2, 4 and 8 bytes (which must be
+ * aligned to their size), other sizes is copied bytewise.
+ *
+ * ex:
+ *    ijss_columns_init(&columns, &sparse_set);
+ *    ijss_columns_register(&columns, positions, sizeof *positions, sizeof *positions);
+ *    ijss_columns_register(&columns, velocities, sizeof *velocities, sizeof *velocities);
+ *    dense_index = ijss_columns_add(&columns, entity);
+ *    positions[dense_index] = p;
+ *    velocities[dense_index] = v;
+ *    ...
+ *    ijss_columns_remove(&columns, entity);
+ */
+struct ijss_columns {
+   struct ijss *set;
+   unsigned num_columns;
+   struct ijss_column columns[IJSS_COLUMNS_MAX];
+};
+
+IJSS_API void ijss_columns_init(struct ijss_columns *self, struct ijss *set);
+
+/* returns the index of the column */
+IJSS_API unsigned ijss_columns_register(struct ijss_columns *self, void *base, unsigned element_size, unsigned stride);
+
+/* applies moves (dst = src) or swaps to all columns */
+IJSS_API void ijss_columns_apply_moves(struct ijss_columns *self, const struct ijss_move *moves, unsigned num_moves);
+IJSS_API void ijss_columns_apply_swaps(struct ijss_columns *self, const struct ijss_move *swaps, unsigned num_swaps);
+
+/* reorders all columns by a permutation from 'ijss_sort', 'scratch' must have
+ * room for 'n' elements of the largest column */
+IJSS_API void ijss_columns_apply_permutation(struct ijss_columns *self, const unsigned *permutation, unsigned n, void *scratch);
+
+/* the operations on the set with the columns moved along.
+ * 'moves_scratch' must have room for 'n' (remove_n) or the number of deferred
+ * removals (compact), 'ijss_columns_sort' takes the scratch memories of
+ * 'ijss_sort' and 'ijss_columns_apply_permutation' */
+IJSS_API unsigned ijss_columns_add(struct ijss_columns *self, unsigned sparse_index);
+IJSS_API int ijss_columns_remove(struct ijss_columns *self, unsigned sparse_index);
+IJSS_API void ijss_columns_remove_n(struct ijss_columns *self, const unsigned *sparse_indices, unsigned n, struct ijss_move *moves_scratch);
+IJSS_API void ijss_columns_compact(struct ijss_columns *self, struct ijss_move *moves_scratch);
+IJSS_API void ijss_columns_sort(struct ijss_columns *self, const unsigned *keys, unsigned *permutation_scratch, unsigned *sort_scratch, void *column_scratch);
+
+#ifndef IJSS_PARTITIONS_MAX
+   #define IJSS_PARTITIONS_MAX (8)
+#endif
+
+/* splits the dense array of a sparse set into 'num_partitions' contiguous
+ * regions, partition 'p' is [begin[p], begin[p+1]) and the last ends at the
+ * size of the set. (ex: enabled, disabled, pending destroy)
+ *
+ * moving a sparse index between partitions does one swap per partition boundary
+ * crossed instead of a remove followed by an add.
+ *
+ * all functions stores swaps of (external) dense data in 'swaps_out' (room for
+ * 'num_partitions'), swap my_external_data[to_index] and my_external_data[from_index]
+ * in order, and returns the number of swaps.
+ *
+ * NB: once partitioned, the set must only be added to/removed from through
+ *     'ijss_partition_add'/'ijss_partition_remove'
+ *
+ * ex: (only iterate the enabled)
+ *    for (i = 0; i != ijss_partition_end(&partitions, &sparse_set, ENABLED); ++i)
+ *       update(&my_external_data[i]);
+ */
+struct ijss_partitions {
+   unsigned num_partitions;
+   unsigned begin[IJSS_PARTITIONS_MAX];
+};
+
+/* all current members of 'set' is put in partition 0 */
+IJSS_API void ijss_partitions_init(struct ijss_partitions *self, struct ijss *set, unsigned num_partitions);
+
+#define ijss_partition_begin(self, partition) ((self)->begin[(partition)])
+#define ijss_partition_end(self, set, partition) ((partition) + 1 == (self)->num_partitions ? (set)->size : (self)->begin[(partition) + 1])
+
+/* returns the partition of a sparse index in the set */
+IJSS_API unsigned ijss_partition_of(struct ijss_partitions *self, struct ijss *set, unsigned sparse_index);
+
+IJSS_API unsigned ijss_move_to_partition(struct ijss_partitions *self, struct ijss *set, unsigned sparse_index, unsigned partition, struct ijss_move *swaps_out);
+
+/* adds a sparse index to the set in 'partition', the (external) dense data of it
+ * is written to ijss_dense_index(set, sparse_index) after the swaps is applied.
+ * returns the number of swaps (or IJSS_INVALID_INDEX and none is added if the
+ * page for a paged sparse set could not be allocated) */
+IJSS_API unsigned ijss_partition_add(struct ijss_partitions *self, struct ijss *set, unsigned sparse_index, unsigned partition, struct ijss_move *swaps_out);
+
+/* removes a sparse index (that must be in the set) */
+IJSS_API unsigned ijss_partition_remove(struct ijss_partitions *self, struct ijss *set, unsigned sparse_index, struct ijss_move *swaps_out);
+
+/* versions of the above specialized for a fixed elementsize (1, 2 or 4 bytes)
+ * which avoids the per-access dispatch on 'elementsize' (the generic versions
+ * dispatches once per call to these).
+ * NB: the sparse set must have been initialized with the matching elementsize
+ *     and a flat sparse side (ijss_init), see the '_paged' versions below */
+IJSS_API unsigned ijss8_add(struct ijss *self, unsigned sparse_index);
+IJSS_API int ijss8_remove(struct ijss *self, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index);
+IJSS_API unsigned ijss8_dense_index(struct ijss *self, unsigned sparse_index);
+IJSS_API unsigned ijss8_sparse_index(struct ijss *self, unsigned dense_index);
+IJSS_API int ijss8_has(struct ijss *self, unsigned sparse_index);
+
+IJSS_API unsigned ijss16_add(struct ijss *self, unsigned sparse_index);
+IJSS_API int ijss16_remove(struct ijss *self, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index);
+IJSS_API unsigned ijss16_dense_index(struct ijss *self, unsigned sparse_index);
+IJSS_API unsigned ijss16_sparse_index(struct ijss *self, unsigned dense_index);
+IJSS_API int ijss16_has(struct ijss *self, unsigned sparse_index);
+
+IJSS_API unsigned ijss32_add(struct ijss *self, unsigned sparse_index);
+IJSS_API int ijss32_remove(struct ijss *self, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index);
+IJSS_API unsigned ijss32_dense_index(struct ijss *self, unsigned sparse_index);
+IJSS_API unsigned ijss32_sparse_index(struct ijss *self, unsigned dense_index);
+IJSS_API int ijss32_has(struct ijss *self, unsigned sparse_index);
+
+/* same as above for sets with a paged sparse side (ijss_init_paged) */
+IJSS_API unsigned ijss8_paged_add(struct ijss *self, unsigned sparse_index);
+IJSS_API int ijss8_paged_remove(struct ijss *self, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index);
+IJSS_API unsigned ijss8_paged_dense_index(struct ijss *self, unsigned sparse_index);
+IJSS_API unsigned ijss8_paged_sparse_index(struct ijss *self, unsigned dense_index);
+IJSS_API int ijss8_paged_has(struct ijss *self, unsigned sparse_index);
+
+IJSS_API unsigned ijss16_paged_add(struct ijss *self, unsigned sparse_index);
+IJSS_API int ijss16_paged_remove(struct ijss *self, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index);
+IJSS_API unsigned ijss16_paged_dense_index(struct ijss *self, unsigned sparse_index);
+IJSS_API unsigned ijss16_paged_sparse_index(struct ijss *self, unsigned dense_index);
+IJSS_API int ijss16_paged_has(struct ijss *self, unsigned sparse_index);
+
+IJSS_API unsigned ijss32_paged_add(struct ijss *self, unsigned sparse_index);
+IJSS_API int ijss32_paged_remove(struct ijss *self, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index);
+IJSS_API unsigned ijss32_paged_dense_index(struct ijss *self, unsigned sparse_index);
+IJSS_API unsigned ijss32_paged_sparse_index(struct ijss *self, unsigned dense_index);
+IJSS_API int ijss32_paged_has(struct ijss *self, unsigned sparse_index);
+
+/* 64-bit sparse indices (elementsize 8, ex: struct ijss_pair64) for keying a set
+ * by 64-bit ids. dense indices is still 32-bit, so the pages of a paged sparse
+ * side stores 4 byte dense indices (the dense side and a flat sparse side is 8
+ * bytes per element).
+ * the range of the ids is bounded by the sparse side, [0, capacity) if flat and
+ * [0, num_pages*IJSS_SPARSE_PAGE_SIZE) if paged, i.e. the (single level) page
+ * table must cover the largest id, it does not span the whole 64-bit space.
+ * 'sparse_capacity' is clamped to 0xffffffff for larger page tables.
+ *
+ * the generic ijss_add, ijss_remove, ijss_has, ijss_dense_index,
+ * ijss_sparse_index, ijss_has_n and ijss_dense_index_n forwards to these, and
+ * ijss_build handles elementsize 8 as well (for sparse indices that fits in 32
+ * bits, ijss_sparse_index returns IJSS_INVALID_INDEX for one that doesn't).
+ * so does the versions and columns add/remove that is built on them.
+ * NB: the functions that reads or writes the dense/sparse arrays directly is
+ *     not supported (asserts) for elementsize 8: ijss_add_n, ijss_remove_n,
+ *     ijss_reset_identity, ijss_swap, ijss_join_*, ijss_group_*,
+ *     ijss_serialize, ijss_deserialize, ijss_sort, ijss_sort_incremental,
+ *     ijss_remove_deferred, ijss_is_tombstone, ijss_compact, ijss_reserve_ts,
+ *     ijss_add_ts, ijss_set_pair, the partitions and ijss_columns_remove_n,
+ *     ijss_columns_compact and ijss_columns_sort */
+IJSS_API unsigned ijss64_add(struct ijss *self, ijss_uint64 sparse_index);
+IJSS_API int ijss64_remove(struct ijss *self, ijss_uint64 sparse_index, unsigned *move_to_index, unsigned *move_from_index);
+IJSS_API unsigned ijss64_dense_index(struct ijss *self, ijss_uint64 sparse_index);
+IJSS_API ijss_uint64 ijss64_sparse_index(struct ijss *self, unsigned dense_index);
+IJSS_API int ijss64_has(struct ijss *self, ijss_uint64 sparse_index);
+
 #ifdef __cplusplus
    }
 #endif
@@ -153,6 +759,40 @@ IJSS_API int ijss_has(struct ijss *self, unsigned sparse_index);
    #define IJSS_assert assert
 #endif
 
+#if defined(__AVX2__) && !defined(IJSS_NO_SIMD)
+   #define IJSS__AVX2 (1)
+   #include <immintrin.h>
+   #include <stddef.h>
+#endif
+
+#if (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && !defined(IJSS_NO_SIMD)
+   #define IJSS__SSE2 (1)
+   #include <emmintrin.h>
+#endif
+
+#if IJSS_HAS_ATOMICS
+   #if _WIN32
+      #ifdef __cplusplus
+         #define IJSS__EXTERNC_DECL_BEGIN extern "C" {
+         #define IJSS__EXTERNC_DECL_END }
+      #else
+         #define IJSS__EXTERNC_DECL_BEGIN
+         #define IJSS__EXTERNC_DECL_END
+      #endif
+
+      IJSS__EXTERNC_DECL_BEGIN
+         long _InterlockedCompareExchange(long volatile *Destination, long Exchange, long Comparand);
+      IJSS__EXTERNC_DECL_END
+
+      #pragma intrinsic(_InterlockedCompareExchange)
+      /* returns the value before the operation */
+      #define IJSS_InterlockedCompareExchange(ptr, exchange, comparand) ((unsigned)_InterlockedCompareExchange((long volatile*)(ptr), (long)(exchange), (long)(comparand)))
+   #else
+      /* returns the value before the operation */
+      #define IJSS_InterlockedCompareExchange(ptr, exchange, comparand) __sync_val_compare_and_swap((ptr), (comparand), (exchange))
+   #endif
+#endif
+
 static unsigned ijss__load(const void * const p, unsigned len)
 {
    IJSS_assert(len >= 1 && len <= 4);
@@ -178,8 +818,14 @@ static void ijss__store(void *dst, unsigned len, unsigned value)
 
 IJSS_API void ijss_init(struct ijss *self, void *dense, unsigned dense_stride, void *sparse, unsigned sparse_stride, unsigned elementsize, unsigned capacity)
 {
-   IJSS_assert(elementsize >= 1 && elementsize <= 4);
-   IJSS_assert((0xffffffffu >> (8 * (4 - elementsize))) >= capacity);
+   ijss_initex(self, dense, dense_stride, sparse, sparse_stride, elementsize, capacity, capacity);
+}
+
+IJSS_API void ijss_initex(struct ijss *self, void *dense, unsigned dense_stride, void *sparse, unsigned sparse_stride, unsigned elementsize, unsigned capacity, unsigned sparse_capacity)
+{
+   IJSS_assert(elementsize == 1 || elementsize == 2 || elementsize == 4 || elementsize == 8);
+   IJSS_assert(elementsize >= 4 || (0xffffffffu >> (8 * (4 - elementsize))) >= capacity);
+   IJSS_assert(elementsize >= 4 || sparse_capacity == 0 || (0xffffffffu >> (8 * (4 - elementsize))) >= sparse_capacity - 1);
 
    self->dense = dense;
    self->dense_stride = dense_stride;
@@ -188,24 +834,82 @@ IJSS_API void ijss_init(struct ijss *self, void *dense, unsigned dense_stride, v
    self->size = 0;
    self->capacity = capacity;
    self->elementsize = elementsize;
+   self->flags = 0;
+   self->sparse_capacity = sparse_capacity;
    self->reserved32 = 0;
    ijss_reset(self);
 }
 
+/* unallocated pages refers to this. any content would do as a sparse index
+ * not in the set never has D[S[x]] == x, regardless of what S[x] is */
+static const unsigned ijss__empty_sparse_page[IJSS_SPARSE_PAGE_SIZE] = {0};
+
+IJSS_API const void *ijss_sparse_empty_page(void)
+{
+   return ijss__empty_sparse_page;
+}
+
+IJSS_API void ijss_init_paged(struct ijss *self, void *dense, unsigned dense_stride, struct ijss_sparse_pages *sparse_pages, unsigned elementsize, unsigned capacity)
+{
+   unsigned i;
+   /* the 64-bit functions bounds the sparse index by the number of pages instead */
+   IJSS_assert(sparse_pages->num_pages >= 1);
+   IJSS_assert(elementsize == 8 || sparse_pages->num_pages <= (0xffffffffu >> IJSS_SPARSE_PAGE_SHIFT));
+   IJSS_assert(elementsize >= 4 || (0xffffffffu >> (8 * (4 - elementsize))) >= (sparse_pages->num_pages << IJSS_SPARSE_PAGE_SHIFT) - 1);
+
+   /* the pages of 64-bit sets only needs room for the 32-bit dense indices */
+   ijss_init(self, dense, dense_stride, sparse_pages, elementsize == 8 ? sizeof(unsigned) : elementsize, elementsize, capacity);
+   for (i = 0; i != sparse_pages->num_pages; ++i)
+      sparse_pages->pages[i] = (void*)ijss__empty_sparse_page;
+   sparse_pages->num_allocated_pages = 0;
+   self->flags |= IJSS_FLAGS_PAGED_SPARSE;
+   self->sparse_capacity = sparse_pages->num_pages <= (0xffffffffu >> IJSS_SPARSE_PAGE_SHIFT) ? sparse_pages->num_pages << IJSS_SPARSE_PAGE_SHIFT : 0xffffffffu;
+}
+
+static int ijss__sparse_page_reserve(struct ijss *self, unsigned page_index)
+{
+   struct ijss_sparse_pages *sparse_pages = (struct ijss_sparse_pages *)self->sparse;
+   void **page = sparse_pages->pages + page_index;
+
+   IJSS_assert(sparse_pages->num_pages > page_index);
+   if (*page == (void*)ijss__empty_sparse_page) {
+      void *p = sparse_pages->allocate_page(sparse_pages->user_data, self->sparse_stride << IJSS_SPARSE_PAGE_SHIFT);
+      if (!p)
+         return 0;
+      *page = p;
+      ++sparse_pages->num_allocated_pages;
+   }
+   return 1;
+}
+
+IJSS_API int ijss_sparse_page_reserve(struct ijss *self, unsigned sparse_index)
+{
+   if (!(self->flags & IJSS_FLAGS_PAGED_SPARSE))
+      return 1;
+
+   IJSS_assert(self->sparse_capacity > sparse_index);
+   return ijss__sparse_page_reserve(self, sparse_index >> IJSS_SPARSE_PAGE_SHIFT);
+}
+
 #define ijss__pointer_add(type, p, bytes) ((type)((unsigned char *)(p) + (bytes)))
 
 #define IJSS__STORE(p, stride, elementsize, idx, value) ijss__store(ijss__pointer_add(void*, (p), (stride)*(idx)), (elementsize), (value))
 
 /* D[idx] = value */
 #define IJSS__STORE_DENSE(idx, value) IJSS__STORE(self->dense, self->dense_stride, self->elementsize, idx, value)
+/* &S[idx], the sparse side is either an array or a page table */
+#define IJSS__SPARSE_POINTER_FLAT(idx) ijss__pointer_add(void*, self->sparse, self->sparse_stride*(idx))
+#define IJSS__SPARSE_POINTER_PAGED(idx) ijss__pointer_add(void*, ((struct ijss_sparse_pages *)self->sparse)->pages[(idx) >> IJSS_SPARSE_PAGE_SHIFT], self->sparse_stride*((idx) & (IJSS_SPARSE_PAGE_SIZE - 1)))
+#define IJSS__SPARSE_POINTER(idx) ((self->flags & IJSS_FLAGS_PAGED_SPARSE) ? IJSS__SPARSE_POINTER_PAGED(idx) : IJSS__SPARSE_POINTER_FLAT(idx))
+
 /* S[idx] = value */
-#define IJSS__STORE_SPARSE(idx, value) IJSS__STORE(self->sparse, self->sparse_stride, self->elementsize, idx, value)
+#define IJSS__STORE_SPARSE(idx, value) ijss__store(IJSS__SPARSE_POINTER(idx), self->elementsize, (value))
 
 #define IJSS__LOAD(p, stride, elementsize, idx) ijss__load(ijss__pointer_add(void*, (p), (stride)*(idx)), (elementsize))
 /* idx = D[idx] */
 #define IJSS__LOAD_DENSE(idx) IJSS__LOAD(self->dense, self->dense_stride, self->elementsize, idx)
 /* idx = S[idx] */
-#define IJSS__LOAD_SPARSE(idx) IJSS__LOAD(self->sparse, self->sparse_stride, self->elementsize, idx)
+#define IJSS__LOAD_SPARSE(idx) ijss__load(IJSS__SPARSE_POINTER(idx), self->elementsize)
 
 IJSS_API void ijss_reset(struct ijss *self)
 {
@@ -220,312 +924,2953 @@ IJSS_API void ijss_reset_identity(struct ijss *self)
       IJSS__STORE_DENSE(i, i);
 }
 
-IJSS_API unsigned ijss_add(struct ijss *self, unsigned sparse_index)
-{
-   unsigned dense_index = self->size++;
-   IJSS_assert((0xffffffffu >> (8 * (4 - self->elementsize))) >= dense_index);
-   IJSS_assert((0xffffffffu >> (8 * (4 - self->elementsize))) >= sparse_index);
+/* fixed width versions of the load/store macros above, the flat and paged
+ * sparse side is separate instantiations so neither tests the flags per access */
+#define IJSS__LOAD_T(type, p, stride, idx) ((unsigned)*ijss__pointer_add(type*, (p), (stride)*(idx)))
+#define IJSS__STORE_T(type, p, stride, idx, value) (*ijss__pointer_add(type*, (p), (stride)*(idx)) = (type)(value))
+#define IJSS__LOAD_SPARSE_T(type, SPARSE_POINTER, idx) ((unsigned)*(type*)SPARSE_POINTER(idx))
+#define IJSS__STORE_SPARSE_T(type, SPARSE_POINTER, idx, value) (*(type*)SPARSE_POINTER(idx) = (type)(value))
+
+#define IJSS__DEFINE_FIXED_WIDTH(NAME, type, PAGED, SPARSE_POINTER) \
+   IJSS_API int NAME##_has(struct ijss *self, unsigned sparse_index) \
+   { \
+      unsigned dense_index; \
+      IJSS_assert(self->elementsize == sizeof(type)); \
+      IJSS_assert(!(self->flags & IJSS_FLAGS_PAGED_SPARSE) == !PAGED); \
+      if (sparse_index >= self->sparse_capacity) \
+         return 0; \
+      dense_index = IJSS__LOAD_SPARSE_T(type, SPARSE_POINTER, sparse_index); \
+      return self->size > dense_index && IJSS__LOAD_T(type, self->dense, self->dense_stride, dense_index) == sparse_index; \
+   } \
+   \
+   IJSS_API unsigned NAME##_add(struct ijss *self, unsigned sparse_index) \
+   { \
+      unsigned dense_index = self->size; \
+      IJSS_assert(self->elementsize == sizeof(type)); \
+      IJSS_assert(!(self->flags & IJSS_FLAGS_PAGED_SPARSE) == !PAGED); \
+      IJSS_assert(self->capacity > dense_index); \
+      IJSS_assert(self->sparse_capacity > sparse_index); \
+      if (PAGED && !ijss__sparse_page_reserve(self, sparse_index >> IJSS_SPARSE_PAGE_SHIFT)) \
+         return IJSS_INVALID_INDEX; \
+      self->size = dense_index + 1; \
+      IJSS__STORE_T(type, self->dense, self->dense_stride, dense_index, sparse_index); \
+      IJSS__STORE_SPARSE_T(type, SPARSE_POINTER, sparse_index, dense_index); \
+      return dense_index; \
+   } \
+   \
+   IJSS_API int NAME##_remove(struct ijss *self, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index) \
+   { \
+      unsigned size_now, dense_index_of_removed, sparse_index_of_back; \
+      if (!NAME##_has(self, sparse_index)) \
+         return -1; \
+      size_now = self->size-1; \
+      dense_index_of_removed = IJSS__LOAD_SPARSE_T(type, SPARSE_POINTER, sparse_index); \
+      sparse_index_of_back = IJSS__LOAD_T(type, self->dense, self->dense_stride, size_now); \
+      /* see 'ijss_remove' */ \
+      IJSS__STORE_T(type, self->dense, self->dense_stride, size_now, sparse_index); \
+      IJSS__STORE_T(type, self->dense, self->dense_stride, dense_index_of_removed, sparse_index_of_back); \
+      IJSS__STORE_SPARSE_T(type, SPARSE_POINTER, sparse_index_of_back, dense_index_of_removed); \
+      *move_from_index = size_now; \
+      *move_to_index = dense_index_of_removed; \
+      self->size = size_now; \
+      return dense_index_of_removed != size_now; \
+   } \
+   \
+   IJSS_API unsigned NAME##_dense_index(struct ijss *self, unsigned sparse_index) \
+   { \
+      IJSS_assert(self->elementsize == sizeof(type)); \
+      IJSS_assert(!(self->flags & IJSS_FLAGS_PAGED_SPARSE) == !PAGED); \
+      IJSS_assert(self->sparse_capacity > sparse_index); \
+      return IJSS__LOAD_SPARSE_T(type, SPARSE_POINTER, sparse_index); \
+   } \
+   \
+   IJSS_API unsigned NAME##_sparse_index(struct ijss *self, unsigned dense_index) \
+   { \
+      IJSS_assert(self->elementsize == sizeof(type)); \
+      IJSS_assert(self->capacity > dense_index); \
+      return IJSS__LOAD_T(type, self->dense, self->dense_stride, dense_index); \
+   }
 
-   IJSS_assert(self->capacity > dense_index);
-   IJSS_assert(self->capacity > sparse_index);
+IJSS__DEFINE_FIXED_WIDTH(ijss8, unsigned char, 0, IJSS__SPARSE_POINTER_FLAT)
+IJSS__DEFINE_FIXED_WIDTH(ijss16, unsigned short, 0, IJSS__SPARSE_POINTER_FLAT)
+IJSS__DEFINE_FIXED_WIDTH(ijss32, unsigned, 0, IJSS__SPARSE_POINTER_FLAT)
+IJSS__DEFINE_FIXED_WIDTH(ijss8_paged, unsigned char, 1, IJSS__SPARSE_POINTER_PAGED)
+IJSS__DEFINE_FIXED_WIDTH(ijss16_paged, unsigned short, 1, IJSS__SPARSE_POINTER_PAGED)
+IJSS__DEFINE_FIXED_WIDTH(ijss32_paged, unsigned, 1, IJSS__SPARSE_POINTER_PAGED)
 
-   IJSS__STORE_DENSE(dense_index, sparse_index);
-   IJSS__STORE_SPARSE(sparse_index, dense_index);
+#undef IJSS__DEFINE_FIXED_WIDTH
+
+/* 64-bit sparse indices, 'IJSS__SPARSE_POINTER' works with a 64-bit index as is.
+ * a flat sparse side has 8 byte elements, the pages 4 byte */
+#define IJSS__LOAD_SPARSE_64(idx) ((self->flags & IJSS_FLAGS_PAGED_SPARSE) ? *(unsigned*)IJSS__SPARSE_POINTER_PAGED(idx) : (unsigned)*(ijss_uint64*)IJSS__SPARSE_POINTER_FLAT(idx))
+#define IJSS__STORE_SPARSE_64(idx, value) ((self->flags & IJSS_FLAGS_PAGED_SPARSE) ? (void)(*(unsigned*)IJSS__SPARSE_POINTER_PAGED(idx) = (value)) : (void)(*(ijss_uint64*)IJSS__SPARSE_POINTER_FLAT(idx) = (ijss_uint64)(value)))
+#define IJSS__DENSE_64(idx) (*ijss__pointer_add(ijss_uint64*, self->dense, self->dense_stride*(idx)))
+
+static int ijss64__in_range(struct ijss *self, ijss_uint64 sparse_index)
+{
+   if (self->flags & IJSS_FLAGS_PAGED_SPARSE)
+      return (sparse_index >> IJSS_SPARSE_PAGE_SHIFT) < ((struct ijss_sparse_pages *)self->sparse)->num_pages;
+   return sparse_index < self->sparse_capacity;
+}
+
+IJSS_API int ijss64_has(struct ijss *self, ijss_uint64 sparse_index)
+{
+   unsigned dense_index;
+   IJSS_assert(self->elementsize == 8);
+   if (!ijss64__in_range(self, sparse_index))
+      return 0;
+   dense_index = IJSS__LOAD_SPARSE_64(sparse_index);
+   return self->size > dense_index && IJSS__DENSE_64(dense_index) == sparse_index;
+}
 
+IJSS_API unsigned ijss64_add(struct ijss *self, ijss_uint64 sparse_index)
+{
+   unsigned dense_index = self->size;
+   IJSS_assert(self->elementsize == 8);
+   IJSS_assert(self->capacity > dense_index);
+   IJSS_assert(ijss64__in_range(self, sparse_index));
+   if ((self->flags & IJSS_FLAGS_PAGED_SPARSE) && !ijss__sparse_page_reserve(self, (unsigned)(sparse_index >> IJSS_SPARSE_PAGE_SHIFT)))
+      return IJSS_INVALID_INDEX;
+   self->size = dense_index + 1;
+   IJSS__DENSE_64(dense_index) = sparse_index;
+   IJSS__STORE_SPARSE_64(sparse_index, dense_index);
    return dense_index;
 }
 
-IJSS_API int ijss_remove(struct ijss *self, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index)
+IJSS_API int ijss64_remove(struct ijss *self, ijss_uint64 sparse_index, unsigned *move_to_index, unsigned *move_from_index)
 {
-   if (!ijss_has(self, sparse_index))
+   unsigned size_now, dense_index_of_removed;
+   ijss_uint64 sparse_index_of_back;
+   if (!ijss64_has(self, sparse_index))
       return -1;
-   else {
-      unsigned size_now = self->size-1;
-      unsigned dense_index_of_removed, sparse_index_of_back;
-      IJSS_assert(self->capacity > size_now);
-
-      dense_index_of_removed = IJSS__LOAD_SPARSE(sparse_index);
-      IJSS_assert(self->capacity > dense_index_of_removed);
-      IJSS_assert(size_now >= dense_index_of_removed);
-      sparse_index_of_back = IJSS__LOAD_DENSE(size_now);
+   size_now = self->size-1;
+   dense_index_of_removed = IJSS__LOAD_SPARSE_64(sparse_index);
+   sparse_index_of_back = IJSS__DENSE_64(size_now);
+   /* see 'ijss_remove' */
+   IJSS__DENSE_64(size_now) = sparse_index;
+   IJSS__DENSE_64(dense_index_of_removed) = sparse_index_of_back;
+   IJSS__STORE_SPARSE_64(sparse_index_of_back, dense_index_of_removed);
+   *move_from_index = size_now;
+   *move_to_index = dense_index_of_removed;
+   self->size = size_now;
+   return dense_index_of_removed != size_now;
+}
 
-      /* #1 is not strictly necessary, but together with 'ijss_reset_identity'
-       * we can make a LIFO index/handle allocator */
-      IJSS__STORE_DENSE(size_now, sparse_index); /* #1 */
-      IJSS__STORE_DENSE(dense_index_of_removed, sparse_index_of_back);
-      IJSS__STORE_SPARSE(sparse_index_of_back, dense_index_of_removed);
+IJSS_API unsigned ijss64_dense_index(struct ijss *self, ijss_uint64 sparse_index)
+{
+   IJSS_assert(self->elementsize == 8);
+   IJSS_assert(ijss64__in_range(self, sparse_index));
+   return IJSS__LOAD_SPARSE_64(sparse_index);
+}
 
-      *move_from_index = size_now;
-      *move_to_index = dense_index_of_removed;
-      --self->size;
+IJSS_API ijss_uint64 ijss64_sparse_index(struct ijss *self, unsigned dense_index)
+{
+   IJSS_assert(self->elementsize == 8);
+   IJSS_assert(self->capacity > dense_index);
+   return IJSS__DENSE_64(dense_index);
+}
 
-      return dense_index_of_removed != size_now;
+#undef IJSS__DENSE_64
+#undef IJSS__STORE_SPARSE_64
+#undef IJSS__LOAD_SPARSE_64
+
+/* dispatch once on elementsize (and flat/paged sparse side) to the fixed width version */
+#define IJSS__DISPATCH(func, args) \
+   if (self->flags & IJSS_FLAGS_PAGED_SPARSE) { \
+      switch (self->elementsize) { \
+         case 1: return ijss8_paged_##func args; \
+         case 2: return ijss16_paged_##func args; \
+         case 8: return ijss64_##func args; \
+         default: IJSS_assert(self->elementsize == 4); return ijss32_paged_##func args; \
+      } \
+   } \
+   switch (self->elementsize) { \
+      case 1: return ijss8_##func args; \
+      case 2: return ijss16_##func args; \
+      case 8: return ijss64_##func args; \
+      default: IJSS_assert(self->elementsize == 4); return ijss32_##func args; \
    }
+
+IJSS_API unsigned ijss_add(struct ijss *self, unsigned sparse_index)
+{
+   IJSS__DISPATCH(add, (self, sparse_index))
+}
+
+IJSS_API int ijss_remove(struct ijss *self, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index)
+{
+   IJSS__DISPATCH(remove, (self, sparse_index, move_to_index, move_from_index))
 }
 
 IJSS_API int ijss_has(struct ijss *self, unsigned sparse_index)
 {
-   if (sparse_index >= self->capacity)
-      return 0;
-   else {
-      unsigned dense_index = IJSS__LOAD_SPARSE(sparse_index);
-      return self->size > dense_index && IJSS__LOAD_DENSE(dense_index) == sparse_index;
-   }
+   IJSS__DISPATCH(has, (self, sparse_index))
 }
 
+/* single access, no need to dispatch (other than for 64-bit sparse indices) */
 IJSS_API unsigned ijss_dense_index(struct ijss *self, unsigned sparse_index)
 {
-   IJSS_assert(self->capacity > sparse_index);
+   if (self->elementsize == 8)
+      return ijss64_dense_index(self, sparse_index);
+   IJSS_assert(self->sparse_capacity > sparse_index);
    return IJSS__LOAD_SPARSE(sparse_index);
 }
 
 IJSS_API unsigned ijss_sparse_index(struct ijss *self, unsigned dense_index)
 {
+   if (self->elementsize == 8) {
+      ijss_uint64 sparse_index = ijss64_sparse_index(self, dense_index);
+      return sparse_index < IJSS_INVALID_INDEX ? (unsigned)sparse_index : IJSS_INVALID_INDEX;
+   }
    IJSS_assert(self->capacity > dense_index);
    return IJSS__LOAD_DENSE(dense_index);
 }
 
-#if defined(IJSS_TEST) || defined(IJSS_TEST_MAIN)
+IJSS_API unsigned ijss_add_n(struct ijss *self, const unsigned *sparse_indices, unsigned n)
+{
+   unsigned i, first = self->size;
+   IJSS_assert(self->capacity - self->size >= n);
 
-typedef unsigned int ijss_uint32;
+   if (self->flags & IJSS_FLAGS_PAGED_SPARSE) {
+      for (i = 0; i != n; ++i) {
+         if (!ijss_sparse_page_reserve(self, sparse_indices[i]))
+            return IJSS_INVALID_INDEX;
+      }
+   }
 
-#ifdef _MSC_VER
-   typedef unsigned __int64 ijss_uint64;
-#else
-   typedef unsigned long long ijss_uint64;
-#endif
+   for (i = 0; i != n; ++i) {
+      IJSS_assert(self->sparse_capacity > sparse_indices[i]);
+      IJSS__STORE_DENSE(first + i, sparse_indices[i]);
+      IJSS__STORE_SPARSE(sparse_indices[i], first + i);
+   }
+   self->size += n;
+   return first;
+}
 
-#if defined(__ppc64__) || defined(__aarch64__) || defined(_M_X64) || defined(__x86_64__) || defined(__x86_64)
-   typedef ijss_uint64 ijss_uintptr;
-#else
-   typedef ijss_uint32 ijss_uintptr;
-#endif
+IJSS_API unsigned ijss_remove_n(struct ijss *self, const unsigned *sparse_indices, unsigned n, struct ijss_move *moves_out)
+{
+   /* removed sparse indices is temporarily marked with S[x] = capacity, which is
+    * never a valid dense index (and fits as capacity is representable) */
+   unsigned marker = self->capacity;
+   unsigned i, num_removed = 0, num_moves = 0, new_size, back;
+
+   /* #1: mark and remember the dense index of the removed in moves_out (as scratch) */
+   for (i = 0; i != n; ++i) {
+      unsigned sparse_index = sparse_indices[i];
+      if (ijss_has(self, sparse_index)) {
+         moves_out[num_removed].to_index = IJSS__LOAD_SPARSE(sparse_index);
+         moves_out[num_removed].from_index = sparse_index;
+         IJSS__STORE_SPARSE(sparse_index, marker);
+         ++num_removed;
+      }
+   }
 
-#ifndef offsetof
-   #define ijss_test_offsetof(st, m) ((ijss_uintptr)&(((st *)0)->m))
-#else
-   #define ijss_test_offsetof offsetof
-#endif
+   new_size = self->size - num_removed;
+   back = self->size;
 
-#define SSHA_INVALID_HANDLE (unsigned)-1
-static unsigned ijss_alloc_handle(struct ijss *self, unsigned *dense)
-{
-   unsigned h;
-   if (self->capacity == self->size)
-      return SSHA_INVALID_HANDLE;
+   /* #2: fill the holes in [0, new_size) with the elements in [new_size, size) that is kept.
+    * the move is written at or before the scratch entry that is read. */
+   for (i = 0; i != num_removed; ++i) {
+      unsigned dense_index = moves_out[i].to_index;
+      unsigned sparse_index = moves_out[i].from_index;
+      unsigned sparse_index_of_back;
+      if (dense_index >= new_size)
+         continue;
 
-   /* the sparse indices does not move on adds or removes so we leverage this
-    * fact to use them as handles */
-   h = ijss_sparse_index(self, self->size);
-   *dense = ijss_add(self, h);
-   IJSS_assert(*dense == ijss_dense_index(self, h));
-   IJSS_assert(*dense == self->size-1);
-   return h;
+      do {
+         sparse_index_of_back = IJSS__LOAD_DENSE(--back);
+      } while (IJSS__LOAD_SPARSE(sparse_index_of_back) == marker);
+      IJSS_assert(back >= new_size);
+
+      IJSS__STORE_DENSE(dense_index, sparse_index_of_back);
+      IJSS__STORE_SPARSE(sparse_index_of_back, dense_index);
+      /* keep the removed at the back, see #1 in 'ijss_remove' */
+      IJSS__STORE_DENSE(back, sparse_index);
+
+      moves_out[num_moves].to_index = dense_index;
+      moves_out[num_moves].from_index = back;
+      ++num_moves;
+   }
+
+   /* #3: unmark, the removed now resides in [new_size, size) */
+   for (i = new_size; i != self->size; ++i)
+      IJSS__STORE_SPARSE(IJSS__LOAD_DENSE(i), i);
+
+   self->size = new_size;
+   return num_moves;
 }
 
-static unsigned ijss_handle_valid(struct ijss *self, unsigned handle)
+#if defined(IJSS__AVX2)
+/* processes 8 sparse indices at a time, returns how many was processed (the
+ * rest is left for the scalar version) or 0 if not applicable.
+ *
+ * a 16-bit element is gathered as the aligned 32-bit word it resides in (which
+ * never crosses a page boundary) and then shifted into place, so no load ever
+ * reaches outside of a word that the dense/sparse arrays touches. */
+static unsigned ijss__lookup_n_avx2(struct ijss *self, const unsigned *sparse_indices, unsigned n, unsigned *mask_out, unsigned *dense_out, unsigned *num_found)
 {
-   return ijss_has(self, handle);
+   unsigned i, found = 0;
+   unsigned sparse_misalign = (unsigned)((size_t)self->sparse & 3);
+   unsigned dense_misalign = (unsigned)((size_t)self->dense & 3);
+   unsigned max_stride = self->sparse_stride > self->dense_stride ? self->sparse_stride : self->dense_stride;
+   const int *sparse_base = (const int*)((const unsigned char*)self->sparse - sparse_misalign);
+   const int *dense_base = (const int*)((const unsigned char*)self->dense - dense_misalign);
+   __m256i vzero, vthree, vnot_three, vinvalid, velement_mask, vcapacity_max, vsize_max;
+   __m256i vsparse_stride, vdense_stride, vsparse_misalign, vdense_misalign;
+
+   if (self->elementsize == 1 || self->elementsize == 8 || (self->flags & IJSS_FLAGS_PAGED_SPARSE) || self->size == 0 || n < 8)
+      return 0;
+   /* the byte offsets must fit in the (signed 32-bit) gather indices */
+   if (max_stride == 0 || self->capacity >= 0x7ffffff0u / max_stride)
+      return 0;
+   /* elements must be naturally aligned */
+   if (((sparse_misalign | dense_misalign | self->sparse_stride | self->dense_stride) & (self->elementsize - 1)) != 0)
+      return 0;
+
+   vzero = _mm256_setzero_si256();
+   vthree = _mm256_set1_epi32(3);
+   vnot_three = _mm256_set1_epi32(~3);
+   vinvalid = _mm256_set1_epi32(-1);
+   velement_mask = _mm256_set1_epi32(self->elementsize == 2 ? 0xffff : -1);
+   vcapacity_max = _mm256_set1_epi32((int)(self->capacity - 1));
+   vsize_max = _mm256_set1_epi32((int)(self->size - 1));
+   vsparse_stride = _mm256_set1_epi32((int)self->sparse_stride);
+   vdense_stride = _mm256_set1_epi32((int)self->dense_stride);
+   vsparse_misalign = _mm256_set1_epi32((int)sparse_misalign);
+   vdense_misalign = _mm256_set1_epi32((int)dense_misalign);
+
+   for (i = 0; n - i >= 8; i += 8) {
+      __m256i vsparse_index = _mm256_loadu_si256((const __m256i*)(sparse_indices + i));
+      /* unsigned compares, x <= max <=> min(x, max) == x */
+      __m256i vmask = _mm256_cmpeq_epi32(_mm256_min_epu32(vsparse_index, vcapacity_max), vsparse_index);
+      __m256i voffset = _mm256_add_epi32(_mm256_mullo_epi32(vsparse_index, vsparse_stride), vsparse_misalign);
+      __m256i vdense_index = _mm256_mask_i32gather_epi32(vzero, sparse_base, _mm256_and_si256(voffset, vnot_three), vmask, 1);
+      __m256i vback;
+      unsigned bits;
+
+      vdense_index = _mm256_and_si256(_mm256_srlv_epi32(vdense_index, _mm256_slli_epi32(_mm256_and_si256(voffset, vthree), 3)), velement_mask);
+      vmask = _mm256_and_si256(vmask, _mm256_cmpeq_epi32(_mm256_min_epu32(vdense_index, vsize_max), vdense_index));
+
+      voffset = _mm256_add_epi32(_mm256_mullo_epi32(vdense_index, vdense_stride), vdense_misalign);
+      vback = _mm256_mask_i32gather_epi32(vzero, dense_base, _mm256_and_si256(voffset, vnot_three), vmask, 1);
+      vback = _mm256_and_si256(_mm256_srlv_epi32(vback, _mm256_slli_epi32(_mm256_and_si256(voffset, vthree), 3)), velement_mask);
+      vmask = _mm256_and_si256(vmask, _mm256_cmpeq_epi32(vback, vsparse_index));
+
+      bits = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(vmask));
+      if (mask_out) {
+         if ((i & 31) == 0)
+            mask_out[i >> 5] = 0;
+         mask_out[i >> 5] |= bits << (i & 31);
+      }
+      if (dense_out)
+         _mm256_storeu_si256((__m256i*)(dense_out + i), _mm256_blendv_epi8(vinvalid, vdense_index, vmask));
+      for (; bits; bits &= bits - 1)
+         ++found;
+   }
+
+   *num_found = found;
+   return i;
 }
+#endif
 
-static void ijss_as_handlealloc_test_suite(void)
+#define IJSS__LOOKUP_N_SCALAR(NAME) \
+   for (; i != n; ++i) { \
+      unsigned sparse_index = sparse_indices[i]; \
+      int has = NAME##_has(self, sparse_index); \
+      found += (unsigned)has; \
+      if (mask_out) { \
+         if ((i & 31) == 0) \
+            mask_out[i >> 5] = 0; \
+         mask_out[i >> 5] |= (unsigned)has << (i & 31); \
+      } \
+      if (dense_out) \
+         dense_out[i] = has ? NAME##_dense_index(self, sparse_index) : IJSS_INVALID_INDEX; \
+   }
+
+static unsigned ijss__lookup_n(struct ijss *self, const unsigned *sparse_indices, unsigned n, unsigned *mask_out, unsigned *dense_out)
 {
-#define SSHA_NUM_OBJECTS (4)
-   int r, do_move_data;
-   unsigned i, h, dense, move_from, move_to;
+   unsigned i = 0, found = 0;
+#if defined(IJSS__AVX2)
+   i = ijss__lookup_n_avx2(self, sparse_indices, n, mask_out, dense_out, &found);
+#endif
+   if (self->flags & IJSS_FLAGS_PAGED_SPARSE) {
+      switch (self->elementsize) {
+         case 1: IJSS__LOOKUP_N_SCALAR(ijss8_paged) break;
+         case 2: IJSS__LOOKUP_N_SCALAR(ijss16_paged) break;
+         case 8: IJSS__LOOKUP_N_SCALAR(ijss64) break;
+         default: IJSS__LOOKUP_N_SCALAR(ijss32_paged) break;
+      }
+   } else {
+      switch (self->elementsize) {
+         case 1: IJSS__LOOKUP_N_SCALAR(ijss8) break;
+         case 2: IJSS__LOOKUP_N_SCALAR(ijss16) break;
+         case 8: IJSS__LOOKUP_N_SCALAR(ijss64) break;
+         default: IJSS__LOOKUP_N_SCALAR(ijss32) break;
+      }
+   }
+   return found;
+}
+
+#undef IJSS__LOOKUP_N_SCALAR
+
+IJSS_API unsigned ijss_has_n(struct ijss *self, const unsigned *sparse_indices, unsigned n, unsigned *mask_out)
+{
+   return ijss__lookup_n(self, sparse_indices, n, mask_out, 0);
+}
+
+IJSS_API unsigned ijss_dense_index_n(struct ijss *self, const unsigned *sparse_indices, unsigned n, unsigned *dense_out)
+{
+   return ijss__lookup_n(self, sparse_indices, n, 0, dense_out);
+}
+
+IJSS_API void ijss_join_init(struct ijss_join *self, struct ijss * const *sets, unsigned num_sets)
+{
+   unsigned i;
+   IJSS_assert(num_sets >= 1 && num_sets <= IJSS_JOIN_MAX_SETS);
+
+   self->num_sets = num_sets;
+   self->driver = 0;
+   for (i = 0; i != num_sets; ++i) {
+      IJSS_assert(sets[i]->elementsize <= 4);
+      self->sets[i] = sets[i];
+      if (sets[i]->size < sets[self->driver]->size)
+         self->driver = i;
+   }
+   self->position = 0;
+   self->count = 0;
+   self->cursor = 0;
+}
+
+IJSS_API unsigned ijss_join_next_batch(struct ijss_join *self)
+{
+   struct ijss *driver = self->sets[self->driver];
+   unsigned *sparse_indices = self->sparse_indices;
+   unsigned count = 0;
+
+   self->cursor = 0;
+   while (count == 0 && self->position < driver->size) {
+      unsigned i, s, num_live, num_candidates = driver->size - self->position;
+      if (num_candidates > IJSS_JOIN_BATCH_SIZE)
+         num_candidates = IJSS_JOIN_BATCH_SIZE;
+
+      /* tombstones of the driver (see 'ijss_remove_deferred') is not candidates */
+      for (i = 0, num_live = 0; i != num_candidates; ++i) {
+         if (ijss_is_tombstone(driver, self->position + i))
+            continue;
+         sparse_indices[num_live] = ijss_sparse_index(driver, self->position + i);
+         self->dense_indices[self->driver][num_live] = self->position + i;
+         ++num_live;
+      }
+      self->position += num_candidates;
+      num_candidates = num_live;
+
+      /* narrow down the candidates one set at a time, keeping the dense indices found so far */
+      for (s = 0; s != self->num_sets && num_candidates; ++s) {
+         unsigned *dense_indices = self->dense_indices[s];
+         unsigned k, num_kept = 0;
+         if (s == self->driver)
+            continue;
+
+         ijss_dense_index_n(self->sets[s], sparse_indices, num_candidates, dense_indices);
+         for (i = 0; i != num_candidates; ++i) {
+            if (dense_indices[i] == IJSS_INVALID_INDEX)
+               continue;
+            sparse_indices[num_kept] = sparse_indices[i];
+            for (k = 0; k != s; ++k)
+               self->dense_indices[k][num_kept] = self->dense_indices[k][i];
+            self->dense_indices[self->driver][num_kept] = self->dense_indices[self->driver][i];
+            dense_indices[num_kept] = dense_indices[i];
+            ++num_kept;
+         }
+         num_candidates = num_kept;
+      }
+      count = num_candidates;
+   }
+
+   self->count = count;
+   return count;
+}
+
+IJSS_API int ijss_join_next(struct ijss_join *self, unsigned *sparse_index_out, unsigned *dense_indices_out)
+{
+   unsigned s;
+   if (self->cursor == self->count && ijss_join_next_batch(self) == 0)
+      return 0;
+
+   if (sparse_index_out)
+      *sparse_index_out = self->sparse_indices[self->cursor];
+   for (s = 0; s != self->num_sets; ++s)
+      dense_indices_out[s] = self->dense_indices[s][self->cursor];
+   ++self->cursor;
+   return 1;
+}
+
+IJSS_API void ijss_swap(struct ijss *self, unsigned dense_index_a, unsigned dense_index_b)
+{
+   unsigned sparse_index_a, sparse_index_b;
+   int tombstone_a, tombstone_b;
+   IJSS_assert(self->size > dense_index_a && self->size > dense_index_b);
+
+   sparse_index_a = IJSS__LOAD_DENSE(dense_index_a);
+   sparse_index_b = IJSS__LOAD_DENSE(dense_index_b);
+   /* a tombstone (see 'ijss_remove_deferred') is moved but not pointed back at */
+   tombstone_a = IJSS__LOAD_SPARSE(sparse_index_a) != dense_index_a;
+   tombstone_b = IJSS__LOAD_SPARSE(sparse_index_b) != dense_index_b;
+   IJSS__STORE_DENSE(dense_index_a, sparse_index_b);
+   IJSS__STORE_DENSE(dense_index_b, sparse_index_a);
+   if (!tombstone_a)
+      IJSS__STORE_SPARSE(sparse_index_a, dense_index_b);
+   if (!tombstone_b)
+      IJSS__STORE_SPARSE(sparse_index_b, dense_index_a);
+}
+
+IJSS_API void ijss_group_init(struct ijss_group *self, struct ijss * const *sets, unsigned num_sets)
+{
+   unsigned i;
+   IJSS_assert(num_sets >= 1 && num_sets <= IJSS_GROUP_MAX_SETS);
+
+   for (i = 0; i != num_sets; ++i)
+      self->sets[i] = sets[i];
+   self->num_sets = num_sets;
+   self->size = 0;
+}
+
+IJSS_API int ijss_group_has(struct ijss_group *self, unsigned sparse_index)
+{
+   /* the group members is at the same position in all sets, checking one suffice */
+   return ijss_has(self->sets[0], sparse_index) && self->size > ijss_dense_index(self->sets[0], sparse_index);
+}
+
+IJSS_API int ijss_group_on_add(struct ijss_group *self, unsigned sparse_index, struct ijss_move *swaps_out)
+{
+   unsigned i, group_index = self->size;
+
+   if (ijss_group_has(self, sparse_index))
+      return 0;
+   for (i = 0; i != self->num_sets; ++i) {
+      if (!ijss_has(self->sets[i], sparse_index))
+         return 0;
+   }
+
+   for (i = 0; i != self->num_sets; ++i) {
+      unsigned dense_index = ijss_dense_index(self->sets[i], sparse_index);
+      ijss_swap(self->sets[i], group_index, dense_index);
+      swaps_out[i].to_index = group_index;
+      swaps_out[i].from_index = dense_index;
+   }
+   self->size = group_index + 1;
+   return 1;
+}
+
+IJSS_API int ijss_group_on_remove(struct ijss_group *self, unsigned sparse_index, struct ijss_move *swaps_out)
+{
+   unsigned i, group_index;
+
+   if (!ijss_group_has(self, sparse_index))
+      return 0;
+
+   group_index = --self->size;
+   for (i = 0; i != self->num_sets; ++i) {
+      unsigned dense_index = ijss_dense_index(self->sets[i], sparse_index);
+      ijss_swap(self->sets[i], group_index, dense_index);
+      swaps_out[i].to_index = group_index;
+      swaps_out[i].from_index = dense_index;
+   }
+   return 1;
+}
+
+IJSS_API int ijss_build(struct ijss *self, const unsigned *sparse_indices, unsigned n)
+{
+   unsigned i;
+   IJSS_assert(self->capacity >= n);
+
+   self->size = 0;
+   if (self->flags & IJSS_FLAGS_PAGED_SPARSE) {
+      for (i = 0; i != n; ++i) {
+         if (!ijss_sparse_page_reserve(self, sparse_indices[i]))
+            return 0;
+      }
+   }
+
+#define IJSS__BUILD_LOOP(type) \
+   for (i = 0; i != n; ++i) { \
+      IJSS_assert(self->sparse_capacity > sparse_indices[i]); \
+      IJSS__STORE_T(type, self->dense, self->dense_stride, i, sparse_indices[i]); \
+      IJSS__STORE_SPARSE_T(type, IJSS__SPARSE_POINTER, sparse_indices[i], i); \
+   }
+
+   switch (self->elementsize) {
+      case 1: IJSS__BUILD_LOOP(unsigned char) break;
+      case 2: IJSS__BUILD_LOOP(unsigned short) break;
+      case 8:
+         /* the pages of 64-bit sets has 4 byte dense indices */
+         if (self->flags & IJSS_FLAGS_PAGED_SPARSE) {
+            for (i = 0; i != n; ++i) {
+               IJSS_assert(self->sparse_capacity > sparse_indices[i]);
+               IJSS__STORE_T(ijss_uint64, self->dense, self->dense_stride, i, sparse_indices[i]);
+               IJSS__STORE_SPARSE_T(unsigned, IJSS__SPARSE_POINTER_PAGED, sparse_indices[i], i);
+            }
+            break;
+         }
+         IJSS__BUILD_LOOP(ijss_uint64)
+         break;
+      default:
+         IJSS_assert(self->elementsize == 4);
+#if defined(IJSS__SSE2)
+         if (n >= IJSS_BUILD_STREAM_THRESHOLD && self->dense_stride == sizeof(unsigned)) {
+            /* the dense side is not read back, bypass the cache for it */
+            for (i = 0; i != n; ++i) {
+               IJSS_assert(self->sparse_capacity > sparse_indices[i]);
+               _mm_stream_si32((int*)self->dense + i, (int)sparse_indices[i]);
+               IJSS__STORE_SPARSE_T(unsigned, IJSS__SPARSE_POINTER, sparse_indices[i], i);
+            }
+            _mm_sfence();
+            break;
+         }
+#endif
+         IJSS__BUILD_LOOP(unsigned)
+         break;
+   }
+#undef IJSS__BUILD_LOOP
+
+   self->size = n;
+   return 1;
+}
+
+IJSS_API unsigned ijss_serialize(struct ijss *self, unsigned flags, void *buffer, unsigned buffer_size)
+{
+   unsigned char *out = (unsigned char *)buffer;
+   unsigned i, k, num_bytes = IJSS_SERIALIZE_HEADER_SIZE, num_live = 0, prev = 0;
+   IJSS_assert(self->elementsize <= 4);
+
+   /* size first, so nothing is written if it does not fit. a tombstone is an
+    * element its sparse index does not point back at */
+   for (i = 0; i != self->size; ++i) {
+      unsigned sparse_index = IJSS__LOAD_DENSE(i);
+      if (IJSS__LOAD_SPARSE(sparse_index) != i)
+         continue;
+      ++num_live;
+      if (flags & IJSS_SERIALIZE_DELTA_VARINT) {
+         unsigned delta = sparse_index - prev;
+         unsigned zigzag = (delta << 1) ^ (0u - (delta >> 31));
+         for (++num_bytes; zigzag >= 0x80; zigzag >>= 7)
+            ++num_bytes;
+         prev = sparse_index;
+      }
+   }
+   if (!(flags & IJSS_SERIALIZE_DELTA_VARINT))
+      num_bytes += num_live * self->elementsize;
+
+   if (!out || buffer_size < num_bytes)
+      return num_bytes;
+
+   out[0] = (unsigned char)flags;
+   out[1] = (unsigned char)self->elementsize;
+   for (k = 0; k != 4; ++k)
+      out[2 + k] = (unsigned char)(num_live >> (8 * k));
+   out += IJSS_SERIALIZE_HEADER_SIZE;
+
+   prev = 0;
+   for (i = 0; i != self->size; ++i) {
+      unsigned sparse_index = IJSS__LOAD_DENSE(i);
+      if (IJSS__LOAD_SPARSE(sparse_index) != i)
+         continue;
+      if (flags & IJSS_SERIALIZE_DELTA_VARINT) {
+         unsigned delta = sparse_index - prev;
+         unsigned zigzag = (delta << 1) ^ (0u - (delta >> 31));
+         for (; zigzag >= 0x80; zigzag >>= 7)
+            *out++ = (unsigned char)(zigzag | 0x80);
+         *out++ = (unsigned char)zigzag;
+         prev = sparse_index;
+      } else {
+         for (k = 0; k != self->elementsize; ++k)
+            *out++ = (unsigned char)(sparse_index >> (8 * k));
+      }
+   }
+   return num_bytes;
+}
+
+IJSS_API unsigned ijss_deserialize(struct ijss *self, const void *buffer, unsigned buffer_size)
+{
+   const unsigned char *in = (const unsigned char *)buffer;
+   const unsigned char *end = in + buffer_size;
+   unsigned i, k, flags, elementsize, size = 0, prev = 0;
+   IJSS_assert(self->elementsize <= 4);
+
+   self->size = 0;
+   if (buffer_size < IJSS_SERIALIZE_HEADER_SIZE)
+      return 0;
+   flags = in[0];
+   elementsize = in[1];
+   for (k = 0; k != 4; ++k)
+      size |= (unsigned)in[2 + k] << (8 * k);
+   in += IJSS_SERIALIZE_HEADER_SIZE;
+
+   if ((flags & ~IJSS_SERIALIZE_DELTA_VARINT) || elementsize < 1 || elementsize > 4 || size > self->capacity)
+      return 0;
+
+   /* decode straight into the dense side */
+   for (i = 0; i != size; ++i) {
+      unsigned sparse_index = 0;
+      if (flags & IJSS_SERIALIZE_DELTA_VARINT) {
+         unsigned zigzag = 0, shift = 0, byte;
+         do {
+            if (in == end || shift > 28)
+               return 0;
+            byte = *in++;
+            /* the 5th byte only has 4 bits left of 32 */
+            if (shift == 28 && byte > 0x0f)
+               return 0;
+            zigzag |= (byte & 0x7f) << shift;
+            shift += 7;
+         } while (byte & 0x80);
+         sparse_index = prev + ((zigzag >> 1) ^ (0u - (zigzag & 1)));
+         prev = sparse_index;
+      } else {
+         if ((unsigned)(end - in) < elementsize)
+            return 0;
+         for (k = 0; k != elementsize; ++k)
+            sparse_index |= (unsigned)*in++ << (8 * k);
+      }
+      if (sparse_index >= self->sparse_capacity || !ijss_sparse_page_reserve(self, sparse_index))
+         return 0;
+      IJSS__STORE_DENSE(i, sparse_index);
+   }
+
+   /* one scatter pass, then a duplicate shows up as an element not pointed back at */
+   for (i = 0; i != size; ++i)
+      IJSS__STORE_SPARSE(IJSS__LOAD_DENSE(i), i);
+   for (i = 0; i != size; ++i) {
+      if (IJSS__LOAD_SPARSE(IJSS__LOAD_DENSE(i)) != i)
+         return 0;
+   }
+
+   self->size = size;
+   return (unsigned)(in - (const unsigned char *)buffer);
+}
+
+IJSS_API void ijss_sort(struct ijss *self, const unsigned *keys, unsigned *permutation_out, unsigned *scratch)
+{
+   unsigned counts[4][256];
+   unsigned n = self->size, i, pass;
+   unsigned *key_src = scratch, *key_dst = scratch + n;
+   unsigned *index_src = permutation_out, *index_dst = scratch + 2 * n;
+
+   if (n == 0)
+      return;
+
+   for (pass = 0; pass != 4; ++pass) {
+      for (i = 0; i != 256; ++i)
+         counts[pass][i] = 0;
+   }
+
+   /* all histograms in one pass */
+   for (i = 0; i != n; ++i) {
+      unsigned key = keys ? keys[i] : IJSS__LOAD_DENSE(i);
+      key_src[i] = key;
+      index_src[i] = i;
+      ++counts[0][key & 0xff];
+      ++counts[1][(key >> 8) & 0xff];
+      ++counts[2][(key >> 16) & 0xff];
+      ++counts[3][key >> 24];
+   }
+
+   for (pass = 0; pass != 4; ++pass) {
+      unsigned *count = counts[pass], shift = pass * 8, offset = 0, *t;
+
+      /* all have the same digit, nothing to do */
+      if (count[(key_src[0] >> shift) & 0xff] == n)
+         continue;
+
+      for (i = 0; i != 256; ++i) {
+         unsigned c = count[i];
+         count[i] = offset;
+         offset += c;
+      }
+      for (i = 0; i != n; ++i) {
+         unsigned o = count[(key_src[i] >> shift) & 0xff]++;
+         key_dst[o] = key_src[i];
+         index_dst[o] = index_src[i];
+      }
+      t = key_src; key_src = key_dst; key_dst = t;
+      t = index_src; index_src = index_dst; index_dst = t;
+   }
+
+   if (index_src != permutation_out) {
+      for (i = 0; i != n; ++i)
+         permutation_out[i] = index_src[i];
+   }
+
+   /* rebuild the dense side from a copy of it and point the sparse side back,
+    * except for tombstones (see 'ijss_remove_deferred') which stays tombstones */
+   for (i = 0; i != n; ++i) {
+      unsigned sparse_index = IJSS__LOAD_DENSE(i);
+      scratch[i] = sparse_index;
+      scratch[n + i] = IJSS__LOAD_SPARSE(sparse_index) != i;
+   }
+   for (i = 0; i != n; ++i) {
+      unsigned sparse_index = scratch[permutation_out[i]];
+      IJSS__STORE_DENSE(i, sparse_index);
+      if (!scratch[n + permutation_out[i]])
+         IJSS__STORE_SPARSE(sparse_index, i);
+   }
+}
+
+IJSS_API unsigned ijss_sort_incremental(struct ijss *self, struct ijss_sort_state *state, unsigned *keys, unsigned max_compares, struct ijss_move *swaps_out)
+{
+   unsigned num_swaps = 0, sorted_end = state->sorted_end, position = state->position;
+
+   /* new pass (or the set shrunk since last call) */
+   if (sorted_end >= self->size || position > sorted_end)
+      sorted_end = position = 0;
+
+   while (sorted_end != self->size) {
+      if (position != 0) {
+         unsigned key_prev, key;
+         if (max_compares == 0)
+            break;
+         --max_compares;
+
+         key_prev = keys ? keys[position - 1] : IJSS__LOAD_DENSE(position - 1);
+         key = keys ? keys[position] : IJSS__LOAD_DENSE(position);
+         if (key_prev > key) {
+            ijss_swap(self, position - 1, position);
+            if (keys) {
+               keys[position - 1] = key;
+               keys[position] = key_prev;
+            }
+            swaps_out[num_swaps].to_index = position - 1;
+            swaps_out[num_swaps].from_index = position;
+            ++num_swaps;
+            --position;
+            continue;
+         }
+      }
+      /* in place, next */
+      position = ++sorted_end;
+   }
+
+   state->sorted_end = sorted_end;
+   state->position = position;
+   return num_swaps;
+}
+
+IJSS_API void ijss_set_pair(struct ijss *self, unsigned dense_index, unsigned sparse_index)
+{
+   IJSS_assert(self->size > dense_index);
+   IJSS_assert(self->sparse_capacity > sparse_index);
+   IJSS__STORE_DENSE(dense_index, sparse_index);
+   IJSS__STORE_SPARSE(sparse_index, dense_index);
+}
+
+#if IJSS_HAS_ATOMICS
+IJSS_API unsigned ijss_reserve_ts(struct ijss *self, unsigned n)
+{
+   unsigned first;
+   IJSS_assert(!(self->flags & IJSS_FLAGS_PAGED_SPARSE));
+   IJSS_assert(self->capacity >= n);
+
+   first = *(volatile unsigned*)&self->size;
+   for (;;) {
+      unsigned seen;
+      if (first > self->capacity - n)
+         return IJSS_INVALID_INDEX;
+      /* only commits if no other thread reserved in between */
+      seen = IJSS_InterlockedCompareExchange(&self->size, first + n, first);
+      if (seen == first)
+         return first;
+      first = seen;
+   }
+}
+
+IJSS_API unsigned ijss_add_ts(struct ijss *self, unsigned sparse_index)
+{
+   unsigned dense_index = ijss_reserve_ts(self, 1);
+   if (dense_index != IJSS_INVALID_INDEX)
+      ijss_set_pair(self, dense_index, sparse_index);
+   return dense_index;
+}
+#endif /* IJSS_HAS_ATOMICS */
+
+/* number of elements with 'stride' that spans a whole number of cache lines */
+static unsigned ijss__cache_line_granularity(unsigned stride)
+{
+   unsigned lowest_bit = stride & (0u - stride);
+   if (lowest_bit == 0 || lowest_bit >= IJSS_CACHE_LINE_SIZE)
+      return 1;
+   return IJSS_CACHE_LINE_SIZE / lowest_bit;
+}
+
+IJSS_API unsigned ijss_chunk_size(struct ijss * const *sets, unsigned num_sets, const unsigned *column_strides, unsigned num_columns, unsigned min_chunk_size)
+{
+   /* cache line size is a power of 2 so all granularities is as well and the
+    * largest is a multiple of the others */
+   unsigned i, granularity = 1;
+   for (i = 0; i != num_sets; ++i) {
+      unsigned g = ijss__cache_line_granularity(sets[i]->dense_stride);
+      granularity = g > granularity ? g : granularity;
+   }
+   for (i = 0; i != num_columns; ++i) {
+      unsigned g = ijss__cache_line_granularity(column_strides[i]);
+      granularity = g > granularity ? g : granularity;
+   }
+   if (min_chunk_size < granularity)
+      return granularity;
+   return (min_chunk_size + granularity - 1) / granularity * granularity;
+}
+
+struct ijss__parallel_for_task_data {
+   ijss_range_func func;
+   void *user_data;
+   unsigned count;
+   unsigned chunk_size;
+};
+
+static void ijss__parallel_for_task(void *task_data, unsigned task_index)
+{
+   struct ijss__parallel_for_task_data *data = (struct ijss__parallel_for_task_data *)task_data;
+   unsigned begin = task_index * data->chunk_size;
+   unsigned end = data->count - begin > data->chunk_size ? begin + data->chunk_size : data->count;
+   data->func(data->user_data, begin, end);
+}
+
+IJSS_API void ijss_parallel_for(unsigned count, unsigned chunk_size, ijss_range_func func, void *user_data, ijss_dispatch_func dispatch, void *pool)
+{
+   struct ijss__parallel_for_task_data data;
+   unsigned i, num_tasks;
+   IJSS_assert(chunk_size > 0);
+
+   if (count == 0)
+      return;
+
+   data.func = func;
+   data.user_data = user_data;
+   data.count = count;
+   data.chunk_size = chunk_size;
+   num_tasks = (count - 1) / chunk_size + 1;
+
+   if (dispatch) {
+      dispatch(pool, ijss__parallel_for_task, &data, num_tasks);
+   } else {
+      for (i = 0; i != num_tasks; ++i)
+         ijss__parallel_for_task(&data, i);
+   }
+}
+
+IJSS_API void ijss_versions_init(struct ijss_versions *self, unsigned *versions, unsigned *block_versions, unsigned capacity)
+{
+   unsigned i;
+   self->versions = versions;
+   self->block_versions = block_versions;
+   self->version = 1;
+   self->capacity = capacity;
+   for (i = 0; i != capacity; ++i)
+      versions[i] = 0;
+   for (i = 0; i != IJSS_VERSIONS_NUM_BLOCKS(capacity); ++i)
+      block_versions[i] = 0;
+}
+
+IJSS_API unsigned ijss_versions_advance(struct ijss_versions *self)
+{
+   return ++self->version;
+}
+
+IJSS_API void ijss_touch(struct ijss_versions *self, unsigned dense_index)
+{
+   IJSS_assert(self->capacity > dense_index);
+   self->versions[dense_index] = self->version;
+   self->block_versions[dense_index >> IJSS_VERSIONS_BLOCK_SHIFT] = self->version;
+}
+
+IJSS_API void ijss_versions_move(struct ijss_versions *self, unsigned to_index, unsigned from_index)
+{
+   unsigned version = self->versions[from_index];
+   unsigned *block_version = self->block_versions + (to_index >> IJSS_VERSIONS_BLOCK_SHIFT);
+   IJSS_assert(self->capacity > to_index && self->capacity > from_index);
+
+   self->versions[to_index] = version;
+   /* the block moved from keeps its (now possibly too high) version, which is only conservative */
+   if (*block_version < version)
+      *block_version = version;
+}
+
+IJSS_API void ijss_versions_swap(struct ijss_versions *self, unsigned dense_index_a, unsigned dense_index_b)
+{
+   unsigned version_a = self->versions[dense_index_a];
+   ijss_versions_move(self, dense_index_a, dense_index_b);
+   self->versions[dense_index_b] = version_a;
+   if (self->block_versions[dense_index_b >> IJSS_VERSIONS_BLOCK_SHIFT] < version_a)
+      self->block_versions[dense_index_b >> IJSS_VERSIONS_BLOCK_SHIFT] = version_a;
+}
+
+IJSS_API unsigned ijss_add_versioned(struct ijss *self, struct ijss_versions *versions, unsigned sparse_index)
+{
+   unsigned dense_index = ijss_add(self, sparse_index);
+   if (dense_index != IJSS_INVALID_INDEX)
+      ijss_touch(versions, dense_index);
+   return dense_index;
+}
+
+IJSS_API int ijss_remove_versioned(struct ijss *self, struct ijss_versions *versions, unsigned sparse_index, unsigned *move_to_index, unsigned *move_from_index)
+{
+   int r = ijss_remove(self, sparse_index, move_to_index, move_from_index);
+   if (r > 0)
+      ijss_versions_move(versions, *move_to_index, *move_from_index);
+   return r;
+}
+
+IJSS_API unsigned ijss_next_changed(struct ijss *self, struct ijss_versions *versions, unsigned dense_index, unsigned since)
+{
+   unsigned size = self->size;
+   while (dense_index < size) {
+      if (versions->block_versions[dense_index >> IJSS_VERSIONS_BLOCK_SHIFT] < since) {
+         /* nothing in this block */
+         dense_index = ((dense_index >> IJSS_VERSIONS_BLOCK_SHIFT) + 1) << IJSS_VERSIONS_BLOCK_SHIFT;
+         continue;
+      }
+      if (versions->versions[dense_index] >= since)
+         return dense_index;
+      ++dense_index;
+   }
+   return size;
+}
+
+IJSS_API void ijss_columns_init(struct ijss_columns *self, struct ijss *set)
+{
+   self->set = set;
+   self->num_columns = 0;
+}
+
+IJSS_API unsigned ijss_columns_register(struct ijss_columns *self, void *base, unsigned element_size, unsigned stride)
+{
+   struct ijss_column *column;
+   IJSS_assert(self->num_columns < IJSS_COLUMNS_MAX);
+   IJSS_assert(element_size > 0 && stride >= element_size);
+
+   column = self->columns + self->num_columns;
+   column->base = base;
+   column->element_size = element_size;
+   column->stride = stride;
+   return self->num_columns++;
+}
+
+#define IJSS__COLUMN_ELEMENT(type, column, idx) (*ijss__pointer_add(type*, (column)->base, (column)->stride*(idx)))
+
+/* one loop per column and element size, i.e. the dispatch is once per column */
+#define IJSS__COLUMNS_FOR_EACH_WIDTH(column, LOOP) \
+   switch ((column)->element_size) { \
+      case 1: LOOP(unsigned char) break; \
+      case 2: LOOP(unsigned short) break; \
+      case 4: LOOP(unsigned) break; \
+      case 8: LOOP(ijss_uint64) break; \
+      default: LOOP(unsigned char) break; /* size never matches, i.e. bytewise */ \
+   }
+
+static void ijss__column_copy_bytes(struct ijss_column *column, void *dst, const void *src)
+{
+   unsigned i;
+   for (i = 0; i != column->element_size; ++i)
+      ((unsigned char*)dst)[i] = ((const unsigned char*)src)[i];
+}
+
+IJSS_API void ijss_columns_apply_moves(struct ijss_columns *self, const struct ijss_move *moves, unsigned num_moves)
+{
+   unsigned c, i;
+   for (c = 0; c != self->num_columns; ++c) {
+      struct ijss_column *column = self->columns + c;
+#define IJSS__MOVE_LOOP(type) \
+      if (sizeof(type) == column->element_size) { \
+         for (i = 0; i != num_moves; ++i) \
+            IJSS__COLUMN_ELEMENT(type, column, moves[i].to_index) = IJSS__COLUMN_ELEMENT(type, column, moves[i].from_index); \
+      } else { \
+         for (i = 0; i != num_moves; ++i) \
+            ijss__column_copy_bytes(column, &IJSS__COLUMN_ELEMENT(unsigned char, column, moves[i].to_index), &IJSS__COLUMN_ELEMENT(unsigned char, column, moves[i].from_index)); \
+      }
+      IJSS__COLUMNS_FOR_EACH_WIDTH(column, IJSS__MOVE_LOOP)
+#undef IJSS__MOVE_LOOP
+   }
+}
+
+IJSS_API void ijss_columns_apply_swaps(struct ijss_columns *self, const struct ijss_move *swaps, unsigned num_swaps)
+{
+   unsigned c, i, k;
+   for (c = 0; c != self->num_columns; ++c) {
+      struct ijss_column *column = self->columns + c;
+#define IJSS__SWAP_LOOP(type) \
+      if (sizeof(type) == column->element_size) { \
+         for (i = 0; i != num_swaps; ++i) { \
+            type t = IJSS__COLUMN_ELEMENT(type, column, swaps[i].to_index); \
+            IJSS__COLUMN_ELEMENT(type, column, swaps[i].to_index) = IJSS__COLUMN_ELEMENT(type, column, swaps[i].from_index); \
+            IJSS__COLUMN_ELEMENT(type, column, swaps[i].from_index) = t; \
+         } \
+      } else { \
+         for (i = 0; i != num_swaps; ++i) { \
+            unsigned char *a = &IJSS__COLUMN_ELEMENT(unsigned char, column, swaps[i].to_index); \
+            unsigned char *b = &IJSS__COLUMN_ELEMENT(unsigned char, column, swaps[i].from_index); \
+            for (k = 0; k != column->element_size; ++k) { \
+               unsigned char t = a[k]; \
+               a[k] = b[k]; \
+               b[k] = t; \
+            } \
+         } \
+      }
+      IJSS__COLUMNS_FOR_EACH_WIDTH(column, IJSS__SWAP_LOOP)
+#undef IJSS__SWAP_LOOP
+   }
+}
+
+IJSS_API void ijss_columns_apply_permutation(struct ijss_columns *self, const unsigned *permutation, unsigned n, void *scratch)
+{
+   unsigned c, i;
+   for (c = 0; c != self->num_columns; ++c) {
+      struct ijss_column *column = self->columns + c;
+      /* copy out (packed) and gather back */
+      struct ijss_column packed;
+      packed.base = scratch;
+      packed.element_size = column->element_size;
+      packed.stride = column->element_size;
+#define IJSS__PERMUTE_LOOP(type) \
+      if (sizeof(type) == column->element_size) { \
+         for (i = 0; i != n; ++i) \
+            IJSS__COLUMN_ELEMENT(type, &packed, i) = IJSS__COLUMN_ELEMENT(type, column, i); \
+         for (i = 0; i != n; ++i) \
+            IJSS__COLUMN_ELEMENT(type, column, i) = IJSS__COLUMN_ELEMENT(type, &packed, permutation[i]); \
+      } else { \
+         for (i = 0; i != n; ++i) \
+            ijss__column_copy_bytes(column, &IJSS__COLUMN_ELEMENT(unsigned char, &packed, i), &IJSS__COLUMN_ELEMENT(unsigned char, column, i)); \
+         for (i = 0; i != n; ++i) \
+            ijss__column_copy_bytes(column, &IJSS__COLUMN_ELEMENT(unsigned char, column, i), &IJSS__COLUMN_ELEMENT(unsigned char, &packed, permutation[i])); \
+      }
+      IJSS__COLUMNS_FOR_EACH_WIDTH(column, IJSS__PERMUTE_LOOP)
+#undef IJSS__PERMUTE_LOOP
+   }
+}
+
+#undef IJSS__COLUMNS_FOR_EACH_WIDTH
+#undef IJSS__COLUMN_ELEMENT
+
+IJSS_API unsigned ijss_columns_add(struct ijss_columns *self, unsigned sparse_index)
+{
+   /* added at the back, nothing moves */
+   return ijss_add(self->set, sparse_index);
+}
+
+IJSS_API int ijss_columns_remove(struct ijss_columns *self, unsigned sparse_index)
+{
+   struct ijss_move move;
+   int r = ijss_remove(self->set, sparse_index, &move.to_index, &move.from_index);
+   if (r > 0)
+      ijss_columns_apply_moves(self, &move, 1);
+   return r;
+}
+
+IJSS_API void ijss_columns_remove_n(struct ijss_columns *self, const unsigned *sparse_indices, unsigned n, struct ijss_move *moves_scratch)
+{
+   unsigned num_moves = ijss_remove_n(self->set, sparse_indices, n, moves_scratch);
+   ijss_columns_apply_moves(self, moves_scratch, num_moves);
+}
+
+IJSS_API void ijss_columns_compact(struct ijss_columns *self, struct ijss_move *moves_scratch)
+{
+   unsigned num_moves = ijss_compact(self->set, moves_scratch);
+   ijss_columns_apply_moves(self, moves_scratch, num_moves);
+}
+
+IJSS_API void ijss_columns_sort(struct ijss_columns *self, const unsigned *keys, unsigned *permutation_scratch, unsigned *sort_scratch, void *column_scratch)
+{
+   ijss_sort(self->set, keys, permutation_scratch, sort_scratch);
+   ijss_columns_apply_permutation(self, permutation_scratch, self->set->size, column_scratch);
+}
+
+/* a tombstone is a dense slot whose sparse index no longer points back at it,
+ * the sparse side is marked with S[x] = capacity (never a valid dense index) */
+IJSS_API int ijss_remove_deferred(struct ijss *self, unsigned sparse_index)
+{
+   if (!ijss_has(self, sparse_index))
+      return 0;
+   IJSS__STORE_SPARSE(sparse_index, self->capacity);
+   return 1;
+}
+
+IJSS_API int ijss_is_tombstone(struct ijss *self, unsigned dense_index)
+{
+   IJSS_assert(self->size > dense_index);
+   return IJSS__LOAD_SPARSE(IJSS__LOAD_DENSE(dense_index)) != dense_index;
+}
+
+IJSS_API unsigned ijss_compact(struct ijss *self, struct ijss_move *moves_out)
+{
+   unsigned front = 0, back = self->size, num_moves = 0;
+
+   for (;;) {
+      unsigned sparse_index_of_hole, sparse_index_of_back;
+      while (front != back && !ijss_is_tombstone(self, front))
+         ++front;
+      while (back != front && ijss_is_tombstone(self, back - 1))
+         --back;
+      if (front == back)
+         break;
+
+      /* hole at 'front' and an element at 'back-1', keep the removed at the back */
+      --back;
+      sparse_index_of_hole = IJSS__LOAD_DENSE(front);
+      sparse_index_of_back = IJSS__LOAD_DENSE(back);
+      IJSS__STORE_DENSE(front, sparse_index_of_back);
+      IJSS__STORE_SPARSE(sparse_index_of_back, front);
+      IJSS__STORE_DENSE(back, sparse_index_of_hole);
+
+      moves_out[num_moves].to_index = front;
+      moves_out[num_moves].from_index = back;
+      ++num_moves;
+      ++front;
+   }
+
+   self->size = front;
+   return num_moves;
+}
+
+IJSS_API void ijss_partitions_init(struct ijss_partitions *self, struct ijss *set, unsigned num_partitions)
+{
+   unsigned i;
+   IJSS_assert(num_partitions >= 1 && num_partitions <= IJSS_PARTITIONS_MAX);
+
+   self->num_partitions = num_partitions;
+   self->begin[0] = 0;
+   for (i = 1; i != num_partitions; ++i)
+      self->begin[i] = set->size;
+}
+
+IJSS_API unsigned ijss_partition_of(struct ijss_partitions *self, struct ijss *set, unsigned sparse_index)
+{
+   unsigned partition = self->num_partitions - 1;
+   unsigned dense_index = ijss_dense_index(set, sparse_index);
+   IJSS_assert(ijss_has(set, sparse_index));
+
+   while (dense_index < self->begin[partition])
+      --partition;
+   return partition;
+}
+
+IJSS_API unsigned ijss_move_to_partition(struct ijss_partitions *self, struct ijss *set, unsigned sparse_index, unsigned partition, struct ijss_move *swaps_out)
+{
+   unsigned num_swaps = 0, current = ijss_partition_of(self, set, sparse_index);
+   unsigned dense_index = ijss_dense_index(set, sparse_index);
+   IJSS_assert(partition < self->num_partitions);
+
+   /* towards the back, swap with the last of the current and move the boundary down */
+   for (; current < partition; ++current) {
+      unsigned last = --self->begin[current + 1];
+      if (last != dense_index) {
+         ijss_swap(set, dense_index, last);
+         swaps_out[num_swaps].to_index = last;
+         swaps_out[num_swaps].from_index = dense_index;
+         ++num_swaps;
+         dense_index = last;
+      }
+   }
+
+   /* towards the front, swap with the first of the current and move the boundary up */
+   for (; current > partition; --current) {
+      unsigned first = self->begin[current]++;
+      if (first != dense_index) {
+         ijss_swap(set, dense_index, first);
+         swaps_out[num_swaps].to_index = first;
+         swaps_out[num_swaps].from_index = dense_index;
+         ++num_swaps;
+         dense_index = first;
+      }
+   }
+   return num_swaps;
+}
+
+IJSS_API unsigned ijss_partition_add(struct ijss_partitions *self, struct ijss *set, unsigned sparse_index, unsigned partition, struct ijss_move *swaps_out)
+{
+   /* added to the back, i.e. the last partition */
+   if (ijss_add(set, sparse_index) == IJSS_INVALID_INDEX)
+      return IJSS_INVALID_INDEX;
+   return ijss_move_to_partition(self, set, sparse_index, partition, swaps_out);
+}
+
+IJSS_API unsigned ijss_partition_remove(struct ijss_partitions *self, struct ijss *set, unsigned sparse_index, struct ijss_move *swaps_out)
+{
+   unsigned move_to, move_from;
+   unsigned num_swaps = ijss_move_to_partition(self, set, sparse_index, self->num_partitions - 1, swaps_out);
+
+   /* the removed data ends up at the back, so the move can be reported as a swap */
+   if (ijss_remove(set, sparse_index, &move_to, &move_from) > 0) {
+      swaps_out[num_swaps].to_index = move_to;
+      swaps_out[num_swaps].from_index = move_from;
+      ++num_swaps;
+   }
+   return num_swaps;
+}
+
+#if defined(IJSS_TEST) || defined(IJSS_TEST_MAIN)
+
+typedef unsigned int ijss_uint32;
+
+#if defined(__ppc64__) || defined(__aarch64__) || defined(_M_X64) || defined(__x86_64__) || defined(__x86_64)
+   typedef ijss_uint64 ijss_uintptr;
+#else
+   typedef ijss_uint32 ijss_uintptr;
+#endif
+
+#ifndef offsetof
+   #define ijss_test_offsetof(st, m) ((ijss_uintptr)&(((st *)0)->m))
+#else
+   #define ijss_test_offsetof offsetof
+#endif
+
+/* the test's pseudo random numbers (a LCG), advances 'state' and returns it */
+static unsigned ijss_test_rand(unsigned *state)
+{
+   *state = *state * 1103515245u + 12345u;
+   return *state;
+}
+
+#define SSHA_INVALID_HANDLE (unsigned)-1
+static unsigned ijss_alloc_handle(struct ijss *self, unsigned *dense)
+{
+   unsigned h;
+   if (self->capacity == self->size)
+      return SSHA_INVALID_HANDLE;
+
+   /* the sparse indices does not move on adds or removes so we leverage this
+    * fact to use them as handles */
+   h = ijss_sparse_index(self, self->size);
+   *dense = ijss_add(self, h);
+   IJSS_assert(*dense == ijss_dense_index(self, h));
+   IJSS_assert(*dense == self->size-1);
+   return h;
+}
+
+static unsigned ijss_handle_valid(struct ijss *self, unsigned handle)
+{
+   return ijss_has(self, handle);
+}
+
+static void ijss_as_handlealloc_test_suite(void)
+{
+#define SSHA_NUM_OBJECTS (4)
+   int r, do_move_data;
+   unsigned i, h, dense, move_from, move_to;
    struct ijss_pair32 ssdata[SSHA_NUM_OBJECTS];
    unsigned handles[SSHA_NUM_OBJECTS];
    struct ijss ss, *self = &ss;
 
-   ijss_init_from_pairtype_size(sizeof *ssdata, self, ssdata, sizeof *ssdata, SSHA_NUM_OBJECTS);
-   ijss_reset_identity(self);
+   ijss_init_from_pairtype_size(sizeof *ssdata, self, ssdata, sizeof *ssdata, SSHA_NUM_OBJECTS);
+   ijss_reset_identity(self);
+
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+      h = ijss_alloc_handle(self, &dense);
+      handles[i] = h;
+      IJSS_assert(ijss_handle_valid(self, h));
+   }
+
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+      IJSS_assert(ijss_handle_valid(self, handles[i]));
+      if (i % 2)
+         continue;
+
+      r = ijss_remove(self, i, &move_to, &move_from);
+      IJSS_assert(r >= 0);
+      do_move_data = r > 0;
+      handles[i] = SSHA_INVALID_HANDLE;
+   }
+
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+      if (handles[i] == SSHA_INVALID_HANDLE)
+         IJSS_assert(!ijss_handle_valid(self, handles[i]));
+      else
+         IJSS_assert(ijss_handle_valid(self, handles[i]));
+   }
+
+   for (i = 0; i != 2; ++i) {
+      h = ijss_alloc_handle(self, &dense);
+      IJSS_assert(handles[h] == SSHA_INVALID_HANDLE);
+      handles[h] = h;
+   }
+
+   r = sizeof do_move_data; /* squashing [-Wunused-but-set-variable] */
+
+#undef SSHA_NUM_OBJECTS
+}
+
+struct ijss_test_orientation {
+   int a;
+   unsigned sparse_owner;
+};
+
+struct ijss_test_position {
+   int x, y;
+   unsigned sparse_owner;
+};
+
+struct ijss_test_object {
+   struct ijss_pair32 bookkeeping_position_array;
+   unsigned char somepayload[20];
+   struct ijss_pair8 bookkeeping_orientation_array;
+};
+
+static void ijss_keep_active_external_data_linear(void)
+{
+#define SSHA_NUM_OBJECTS (16)
+   unsigned i;
+   int loop;
+   struct ijss ss_positions;
+   struct ijss ss_orientations;
+   struct ijss_test_object all_test_objects[SSHA_NUM_OBJECTS] = {0};
+   struct ijss_test_orientation all_orientations_array[SSHA_NUM_OBJECTS];
+   struct ijss_test_position all_positions_array[SSHA_NUM_OBJECTS];
+
+   ijss_init_from_pairtype(struct ijss_pair32,
+                           &ss_positions,
+                           (unsigned char*)all_test_objects + ijss_test_offsetof(struct ijss_test_object, bookkeeping_position_array),
+                           sizeof(struct ijss_test_object),
+                           SSHA_NUM_OBJECTS);
+
+   ijss_init_from_pairtype(struct ijss_pair8,
+                           &ss_orientations,
+                           (unsigned char*)all_test_objects + ijss_test_offsetof(struct ijss_test_object, bookkeeping_orientation_array),
+                           sizeof(struct ijss_test_object),
+                           SSHA_NUM_OBJECTS);
+
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+      IJSS_assert(!ijss_has(&ss_positions, i));
+      IJSS_assert(!ijss_has(&ss_orientations, i));
+   }
+
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+      unsigned dense;
+      if (i & 1) {
+         IJSS_assert(!ijss_has(&ss_positions, i));
+         dense = ijss_add(&ss_positions, i);
+         all_positions_array[dense].sparse_owner = i;
+         all_positions_array[dense].x = all_positions_array[dense].y = 0;
+         IJSS_assert(ijss_has(&ss_positions, i));
+      } else {
+         IJSS_assert(!ijss_has(&ss_orientations, i));
+         dense = ijss_add(&ss_orientations, i);
+         all_orientations_array[dense].sparse_owner = i;
+         all_orientations_array[dense].a = 0;
+         IJSS_assert(ijss_has(&ss_orientations, i));
+      }
+   }
+
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+      if (i & 1) {
+         IJSS_assert(!ijss_has(&ss_orientations, i));
+         IJSS_assert(ijss_has(&ss_positions, i));
+      } else {
+         IJSS_assert(!ijss_has(&ss_positions, i));
+         IJSS_assert(ijss_has(&ss_orientations, i));
+      }
+   }
+
+   /* now we have added the objects into either the position or orientation arrays */
+   loop = 0;
+
+   while (ss_orientations.size) {
+
+      for (i = 0; i != ss_orientations.size; ++i) {
+         struct ijss_test_orientation *current = all_orientations_array + i;
+         IJSS_assert(ijss_has(&ss_orientations, current->sparse_owner));
+         IJSS_assert(ijss_dense_index(&ss_orientations, current->sparse_owner) == i);
+         IJSS_assert(ijss_sparse_index(&ss_orientations, i) == current->sparse_owner);
+         IJSS_assert(current->a == loop);
+      }
+
+      for (i = 0; i != ss_positions.size; ++i) {
+         struct ijss_test_position *current = all_positions_array + i;
+         IJSS_assert(ijss_has(&ss_positions, current->sparse_owner));
+         IJSS_assert(ijss_dense_index(&ss_positions, current->sparse_owner) == i);
+         IJSS_assert(ijss_sparse_index(&ss_positions, i) == current->sparse_owner);
+         IJSS_assert(current->x == loop);
+         IJSS_assert(current->y == loop);
+      }
+
+      /* now remove the first of each array */
+      {
+         int r, do_move_data;
+         unsigned move_from, move_to;
+         unsigned sparse_indices[2];
+         sparse_indices[0] = all_orientations_array[0].sparse_owner;
+         sparse_indices[1] = all_positions_array[0].sparse_owner;
+         for (i = 0; i != 2; ++i) {
+            unsigned sparse_index = sparse_indices[i];
+            if (i & 1) {
+               IJSS_assert(!ijss_has(&ss_orientations, sparse_index));
+               IJSS_assert(ijss_has(&ss_positions, sparse_index));
+               r = ijss_remove(&ss_positions, sparse_index, &move_to, &move_from);
+               IJSS_assert(r >= 0);
+               do_move_data = r > 0;
+               IJSS_assert(do_move_data || ss_positions.size == 0); /* otherwise the test is setup incorrectly */
+               all_positions_array[move_to] = all_positions_array[move_from];
+            } else {
+               IJSS_assert(!ijss_has(&ss_positions, sparse_index));
+               IJSS_assert(ijss_has(&ss_orientations, sparse_index));
+               r = ijss_remove(&ss_orientations, sparse_index, &move_to, &move_from);
+               IJSS_assert(r >= 0);
+               do_move_data = r > 0;
+               IJSS_assert(do_move_data || ss_orientations.size == 0); /* otherwise the test is setup incorrectly */
+               all_orientations_array[move_to] = all_orientations_array[move_from];
+            }
+         }
+      }
+
+      /* now loop the linear data again and verify */
+      for (i = 0; i != ss_orientations.size; ++i) {
+         struct ijss_test_orientation *current = all_orientations_array + i;
+         IJSS_assert(ijss_has(&ss_orientations, current->sparse_owner));
+         IJSS_assert(ijss_dense_index(&ss_orientations, current->sparse_owner) == i);
+         IJSS_assert(ijss_sparse_index(&ss_orientations, i) == current->sparse_owner);
+         IJSS_assert(current->a == loop);
+         current->a++;
+      }
+
+      for (i = 0; i != ss_positions.size; ++i) {
+         struct ijss_test_position *current = all_positions_array + i;
+         IJSS_assert(ijss_has(&ss_positions, current->sparse_owner));
+         IJSS_assert(ijss_dense_index(&ss_positions, current->sparse_owner) == i);
+         IJSS_assert(ijss_sparse_index(&ss_positions, i) == current->sparse_owner);
+         IJSS_assert(current->x == loop);
+         IJSS_assert(current->y == loop);
+         current->x++;
+         current->y++;
+      }
+      ++loop;
+   }
+#undef SSHA_NUM_OBJECTS
+
+}
+static void ijss_test_fixed_width(void)
+{
+#define SSHA_NUM_OBJECTS (64)
+   struct ijss_pair8 pairs8[SSHA_NUM_OBJECTS];
+   struct ijss_pair16 pairs16[SSHA_NUM_OBJECTS];
+   struct ijss_pair32 pairs32[SSHA_NUM_OBJECTS];
+   struct ijss_pair32 pairs_generic[SSHA_NUM_OBJECTS];
+   struct ijss ss8, ss16, ss32, ss_generic;
+   unsigned i, rnd = 1;
+
+   ijss_init_from_pairtype(struct ijss_pair8, &ss8, pairs8, sizeof *pairs8, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair16, &ss16, pairs16, sizeof *pairs16, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair32, &ss32, pairs32, sizeof *pairs32, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair32, &ss_generic, pairs_generic, sizeof *pairs_generic, SSHA_NUM_OBJECTS);
+
+   for (i = 0; i != 4096; ++i) {
+      unsigned sparse_index, j;
+      ijss_test_rand(&rnd);
+      sparse_index = (rnd >> 16) % (SSHA_NUM_OBJECTS + 2); /* also test out of range */
+
+      if (sparse_index < SSHA_NUM_OBJECTS && !ijss_has(&ss_generic, sparse_index)) {
+         unsigned dense = ijss_add(&ss_generic, sparse_index);
+         IJSS_assert(ijss8_add(&ss8, sparse_index) == dense);
+         IJSS_assert(ijss16_add(&ss16, sparse_index) == dense);
+         IJSS_assert(ijss32_add(&ss32, sparse_index) == dense);
+      } else {
+         unsigned move_to, move_from, move_to_fw, move_from_fw;
+         int r = ijss_remove(&ss_generic, sparse_index, &move_to, &move_from);
+         IJSS_assert(ijss8_remove(&ss8, sparse_index, &move_to_fw, &move_from_fw) == r);
+         IJSS_assert(r < 0 || (move_to == move_to_fw && move_from == move_from_fw));
+         IJSS_assert(ijss16_remove(&ss16, sparse_index, &move_to_fw, &move_from_fw) == r);
+         IJSS_assert(r < 0 || (move_to == move_to_fw && move_from == move_from_fw));
+         IJSS_assert(ijss32_remove(&ss32, sparse_index, &move_to_fw, &move_from_fw) == r);
+         IJSS_assert(r < 0 || (move_to == move_to_fw && move_from == move_from_fw));
+      }
+
+      for (j = 0; j != SSHA_NUM_OBJECTS; ++j) {
+         int has = ijss_has(&ss_generic, j);
+         IJSS_assert(ijss8_has(&ss8, j) == has);
+         IJSS_assert(ijss16_has(&ss16, j) == has);
+         IJSS_assert(ijss32_has(&ss32, j) == has);
+         if (has) {
+            IJSS_assert(ijss8_dense_index(&ss8, j) == ijss_dense_index(&ss_generic, j));
+            IJSS_assert(ijss16_dense_index(&ss16, j) == ijss_dense_index(&ss_generic, j));
+            IJSS_assert(ijss32_dense_index(&ss32, j) == ijss_dense_index(&ss_generic, j));
+         }
+      }
+      for (j = 0; j != ss_generic.size; ++j) {
+         IJSS_assert(ijss8_sparse_index(&ss8, j) == ijss_sparse_index(&ss_generic, j));
+         IJSS_assert(ijss16_sparse_index(&ss16, j) == ijss_sparse_index(&ss_generic, j));
+         IJSS_assert(ijss32_sparse_index(&ss32, j) == ijss_sparse_index(&ss_generic, j));
+      }
+   }
+#undef SSHA_NUM_OBJECTS
+}
+
+static void ijss_test_add_remove_n(void)
+{
+#define SSHA_NUM_OBJECTS (64)
+   struct ijss_pair16 pairs[SSHA_NUM_OBJECTS];
+   unsigned external_data[SSHA_NUM_OBJECTS];
+   unsigned indices[SSHA_NUM_OBJECTS + 8];
+   struct ijss_move moves[SSHA_NUM_OBJECTS + 8];
+   struct ijss ss, *self = &ss;
+   unsigned i, j, round, rnd = 7;
+
+   ijss_init_from_pairtype(struct ijss_pair16, self, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+
+   for (round = 0; round != 256; ++round) {
+      unsigned n = 0, first, num_moves, num_holes = 0, old_size, new_size;
+
+      /* add some that is not in the set */
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         ijss_test_rand(&rnd);
+         if (!ijss_has(self, i) && ((rnd >> 16) & 3) == 0)
+            indices[n++] = i;
+      }
+      first = ijss_add_n(self, indices, n);
+      for (i = 0; i != n; ++i) {
+         IJSS_assert(ijss_has(self, indices[i]));
+         IJSS_assert(ijss_dense_index(self, indices[i]) == first + i);
+         external_data[first + i] = indices[i];
+      }
+
+      /* remove a random selection, including duplicates and ones not in the set */
+      n = 0;
+      for (i = 0; i != SSHA_NUM_OBJECTS + 8; ++i) {
+         ijss_test_rand(&rnd);
+         if (((rnd >> 16) % 3) == 0)
+            indices[n++] = (rnd >> 20) % (SSHA_NUM_OBJECTS + 2);
+      }
+
+      old_size = self->size;
+      new_size = old_size;
+      for (i = 0; i != n; ++i) {
+         for (j = 0; j != i && indices[j] != indices[i]; ++j) {}
+         if (j == i && ijss_has(self, indices[i]))
+            --new_size;
+      }
+      for (i = 0; i != n; ++i) {
+         for (j = 0; j != i && indices[j] != indices[i]; ++j) {}
+         if (j == i && ijss_has(self, indices[i]) && ijss_dense_index(self, indices[i]) < new_size)
+            ++num_holes;
+      }
+
+      num_moves = ijss_remove_n(self, indices, n, moves);
+      IJSS_assert(self->size == new_size);
+      IJSS_assert(num_moves == num_holes);
+
+      for (i = 0; i != num_moves; ++i) {
+         IJSS_assert(moves[i].to_index < new_size && moves[i].from_index >= new_size);
+         external_data[moves[i].to_index] = external_data[moves[i].from_index];
+      }
+
+      for (i = 0; i != n; ++i)
+         IJSS_assert(!ijss_has(self, indices[i]));
+
+      for (i = 0; i != self->size; ++i) {
+         IJSS_assert(ijss_sparse_index(self, i) == external_data[i]);
+         IJSS_assert(ijss_has(self, external_data[i]));
+         IJSS_assert(ijss_dense_index(self, external_data[i]) == i);
+      }
+
+      /* the removed is kept at the back (see #1 in 'ijss_remove') */
+      for (i = new_size; i != old_size; ++i) {
+         unsigned sparse_index = ijss_sparse_index(self, i);
+         for (j = 0; j != n && indices[j] != sparse_index; ++j) {}
+         IJSS_assert(j != n);
+      }
+   }
+#undef SSHA_NUM_OBJECTS
+}
+
+/* 16-bit indices inlined at an odd (2 byte) offset to exercise the unaligned word gathers */
+struct ijss_test_has_n_object {
+   unsigned short payload;
+   struct ijss_pair16 bookkeeping;
+};
+
+static void ijss_test_has_n(void)
+{
+#define SSHA_NUM_OBJECTS (200)
+   struct ijss_pair8 pairs8[SSHA_NUM_OBJECTS];
+   struct ijss_pair16 pairs16[SSHA_NUM_OBJECTS];
+   struct ijss_pair32 pairs32[SSHA_NUM_OBJECTS];
+   struct ijss_test_has_n_object objects[SSHA_NUM_OBJECTS];
+   struct ijss sets[4];
+   unsigned indices[SSHA_NUM_OBJECTS];
+   unsigned mask[(SSHA_NUM_OBJECTS + 31) / 32];
+   unsigned dense[SSHA_NUM_OBJECTS];
+   unsigned s, i, round, rnd = 3;
+
+   ijss_init_from_pairtype(struct ijss_pair8, &sets[0], pairs8, sizeof *pairs8, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair16, &sets[1], pairs16, sizeof *pairs16, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair32, &sets[2], pairs32, sizeof *pairs32, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair16, &sets[3], (unsigned char*)objects + ijss_test_offsetof(struct ijss_test_has_n_object, bookkeeping), sizeof *objects, SSHA_NUM_OBJECTS);
+
+   for (s = 0; s != 4; ++s) {
+      struct ijss *self = &sets[s];
+
+      /* empty set */
+      for (i = 0; i != 16; ++i)
+         indices[i] = i;
+      IJSS_assert(ijss_has_n(self, indices, 16, mask) == 0);
+      IJSS_assert(mask[0] == 0);
+
+      for (round = 0; round != 64; ++round) {
+         unsigned n, found = 0;
+         ijss_test_rand(&rnd);
+         n = (rnd >> 16) % (SSHA_NUM_OBJECTS + 1);
+
+         /* toggle a few */
+         for (i = 0; i != 16; ++i) {
+            unsigned move_to, move_from, sparse_index;
+            ijss_test_rand(&rnd);
+            sparse_index = (rnd >> 16) % SSHA_NUM_OBJECTS;
+            if (ijss_has(self, sparse_index))
+               ijss_remove(self, sparse_index, &move_to, &move_from);
+            else
+               ijss_add(self, sparse_index);
+         }
+
+         for (i = 0; i != n; ++i) {
+            ijss_test_rand(&rnd);
+            indices[i] = (rnd >> 16) % (SSHA_NUM_OBJECTS + 8); /* also test out of range */
+            if ((rnd & 0x300) == 0x300)
+               indices[i] = 0xffffffffu - (rnd >> 24);
+            found += (unsigned)ijss_has(self, indices[i]);
+         }
+
+         IJSS_assert(ijss_has_n(self, indices, n, mask) == found);
+         IJSS_assert(ijss_dense_index_n(self, indices, n, dense) == found);
+         for (i = 0; i != n; ++i) {
+            int has = ijss_has(self, indices[i]);
+            IJSS_assert(((mask[i >> 5] >> (i & 31)) & 1) == (unsigned)has);
+            IJSS_assert(dense[i] == (has ? ijss_dense_index(self, indices[i]) : IJSS_INVALID_INDEX));
+         }
+      }
+   }
+#undef SSHA_NUM_OBJECTS
+}
+
+static void ijss_test_join(void)
+{
+#define SSHA_NUM_OBJECTS (300)
+   struct ijss_pair16 pairs_a[SSHA_NUM_OBJECTS];
+   struct ijss_pair32 pairs_b[SSHA_NUM_OBJECTS];
+   struct ijss_pair16 pairs_c[SSHA_NUM_OBJECTS];
+   struct ijss a, b, c;
+   struct ijss *sets[3];
+   struct ijss_join join;
+   unsigned char seen[SSHA_NUM_OBJECTS];
+   unsigned i, round, rnd = 11;
+
+   sets[0] = &a; sets[1] = &b; sets[2] = &c;
+   ijss_init_from_pairtype(struct ijss_pair16, &a, pairs_a, sizeof *pairs_a, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair32, &b, pairs_b, sizeof *pairs_b, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair16, &c, pairs_c, sizeof *pairs_c, SSHA_NUM_OBJECTS);
+
+   /* all empty */
+   ijss_join_init(&join, sets, 3);
+   IJSS_assert(ijss_join_next_batch(&join) == 0);
+
+   for (round = 0; round != 32; ++round) {
+      unsigned expected = 0, num_found = 0, sparse_index, dense_indices[3];
+
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         unsigned move_to, move_from;
+         ijss_test_rand(&rnd);
+         if (((rnd >> 16) & 1) != (unsigned)ijss_has(&a, i)) {
+            if (ijss_has(&a, i)) ijss_remove(&a, i, &move_to, &move_from); else ijss_add(&a, i);
+         }
+         if (((rnd >> 17) % 3 != 0) != ijss_has(&b, i)) {
+            if (ijss_has(&b, i)) ijss_remove(&b, i, &move_to, &move_from); else ijss_add(&b, i);
+         }
+         if ((((rnd >> 20) % (round + 2)) == 0) != ijss_has(&c, i)) {
+            if (ijss_has(&c, i)) ijss_remove(&c, i, &move_to, &move_from); else ijss_add(&c, i);
+         }
+         expected += ijss_has(&a, i) && ijss_has(&b, i) && ijss_has(&c, i);
+         seen[i] = 0;
+      }
+
+      ijss_join_init(&join, sets, 3);
+      IJSS_assert(sets[join.driver]->size <= a.size && sets[join.driver]->size <= b.size && sets[join.driver]->size <= c.size);
+      while (ijss_join_next(&join, &sparse_index, dense_indices)) {
+         IJSS_assert(!seen[sparse_index]);
+         seen[sparse_index] = 1;
+         IJSS_assert(ijss_has(&a, sparse_index) && ijss_dense_index(&a, sparse_index) == dense_indices[0]);
+         IJSS_assert(ijss_has(&b, sparse_index) && ijss_dense_index(&b, sparse_index) == dense_indices[1]);
+         IJSS_assert(ijss_has(&c, sparse_index) && ijss_dense_index(&c, sparse_index) == dense_indices[2]);
+         ++num_found;
+      }
+      IJSS_assert(num_found == expected);
+
+      /* a single set yields all of it */
+      num_found = 0;
+      ijss_join_init(&join, sets + 1, 1);
+      while ((i = ijss_join_next_batch(&join)) != 0)
+         num_found += i;
+      IJSS_assert(num_found == b.size);
+   }
+#undef SSHA_NUM_OBJECTS
+}
+
+static void ijss_test_group(void)
+{
+#define SSHA_NUM_OBJECTS (128)
+   struct ijss_pair16 pairs[3][SSHA_NUM_OBJECTS];
+   unsigned external_data[3][SSHA_NUM_OBJECTS];
+   struct ijss sets[3];
+   struct ijss *set_pointers[3];
+   struct ijss_group group;
+   struct ijss_move swaps[3];
+   unsigned i, s, round, rnd = 5;
+
+   for (s = 0; s != 3; ++s) {
+      ijss_init_from_pairtype(struct ijss_pair16, &sets[s], pairs[s], sizeof *pairs[s], SSHA_NUM_OBJECTS);
+      set_pointers[s] = &sets[s];
+   }
+
+   /* some members before the group is created */
+   for (i = 0; i < SSHA_NUM_OBJECTS; i += 3) {
+      for (s = 0; s != 3; ++s) {
+         if (s != 2 || (i & 1))
+            external_data[s][ijss_add(&sets[s], i)] = i;
+      }
+   }
+
+   ijss_group_init(&group, set_pointers, 3);
+   for (i = 0; i != sets[2].size; ++i) {
+      if (ijss_group_on_add(&group, ijss_sparse_index(&sets[2], i), swaps)) {
+         for (s = 0; s != 3; ++s) {
+            unsigned t = external_data[s][swaps[s].to_index];
+            external_data[s][swaps[s].to_index] = external_data[s][swaps[s].from_index];
+            external_data[s][swaps[s].from_index] = t;
+         }
+      }
+   }
+
+   for (round = 0; round != 4096; ++round) {
+      unsigned sparse_index, num_in_all = 0;
+      ijss_test_rand(&rnd);
+      sparse_index = (rnd >> 16) % SSHA_NUM_OBJECTS;
+      s = (rnd >> 8) % 3;
+
+      if (!ijss_has(&sets[s], sparse_index)) {
+         external_data[s][ijss_add(&sets[s], sparse_index)] = sparse_index;
+         if (ijss_group_on_add(&group, sparse_index, swaps)) {
+            for (i = 0; i != 3; ++i) {
+               unsigned t = external_data[i][swaps[i].to_index];
+               external_data[i][swaps[i].to_index] = external_data[i][swaps[i].from_index];
+               external_data[i][swaps[i].from_index] = t;
+            }
+         }
+      } else {
+         unsigned move_to, move_from;
+         if (ijss_group_on_remove(&group, sparse_index, swaps)) {
+            for (i = 0; i != 3; ++i) {
+               unsigned t = external_data[i][swaps[i].to_index];
+               external_data[i][swaps[i].to_index] = external_data[i][swaps[i].from_index];
+               external_data[i][swaps[i].from_index] = t;
+            }
+         }
+         if (ijss_remove(&sets[s], sparse_index, &move_to, &move_from) > 0)
+            external_data[s][move_to] = external_data[s][move_from];
+      }
+
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         int in_all = ijss_has(&sets[0], i) && ijss_has(&sets[1], i) && ijss_has(&sets[2], i);
+         IJSS_assert(ijss_group_has(&group, i) == in_all);
+         num_in_all += (unsigned)in_all;
+      }
+      IJSS_assert(group.size == num_in_all);
+
+      for (i = 0; i != group.size; ++i) {
+         unsigned sparse_index_in_group = ijss_sparse_index(&sets[0], i);
+         IJSS_assert(ijss_sparse_index(&sets[1], i) == sparse_index_in_group);
+         IJSS_assert(ijss_sparse_index(&sets[2], i) == sparse_index_in_group);
+      }
+      for (s = 0; s != 3; ++s) {
+         for (i = 0; i != sets[s].size; ++i)
+            IJSS_assert(external_data[s][i] == ijss_sparse_index(&sets[s], i));
+      }
+   }
+#undef SSHA_NUM_OBJECTS
+}
+
+struct ijss_test_page_pool {
+   unsigned char *memory;
+   unsigned page_size_in_bytes;
+   unsigned num_pages;
+   unsigned num_used;
+};
+
+static void *ijss_test_allocate_page(void *user_data, unsigned page_size_in_bytes)
+{
+   struct ijss_test_page_pool *pool = (struct ijss_test_page_pool *)user_data;
+   IJSS_assert(page_size_in_bytes == pool->page_size_in_bytes);
+   if (pool->num_used == pool->num_pages)
+      return 0;
+   return pool->memory + pool->page_size_in_bytes * pool->num_used++;
+}
+
+static void ijss_test_paged(void)
+{
+#define SSHA_NUM_OBJECTS (256)
+#define SSHA_NUM_PAGES (64)
+#define SSHA_NUM_POOL_PAGES (6)
+   static unsigned page_memory[SSHA_NUM_POOL_PAGES][IJSS_SPARSE_PAGE_SIZE];
+   void *page_table[SSHA_NUM_PAGES];
+   struct ijss_sparse_pages sparse_pages;
+   struct ijss_test_page_pool pool;
+   unsigned dense[SSHA_NUM_OBJECTS];
+   unsigned members[SSHA_NUM_OBJECTS];
+   unsigned indices[SSHA_NUM_OBJECTS];
+   unsigned mask[SSHA_NUM_OBJECTS / 32];
+   struct ijss ss, *self = &ss;
+   unsigned i, j, num_members = 0, rnd = 13;
+
+   pool.memory = (unsigned char*)page_memory;
+   pool.page_size_in_bytes = sizeof page_memory[0];
+   pool.num_pages = SSHA_NUM_POOL_PAGES;
+   pool.num_used = 0;
+
+   sparse_pages.pages = page_table;
+   sparse_pages.num_pages = SSHA_NUM_PAGES;
+   sparse_pages.allocate_page = ijss_test_allocate_page;
+   sparse_pages.user_data = &pool;
+   ijss_init_paged(self, dense, sizeof *dense, &sparse_pages, sizeof *dense, SSHA_NUM_OBJECTS);
+   IJSS_assert(self->sparse_capacity == SSHA_NUM_PAGES * IJSS_SPARSE_PAGE_SIZE);
+
+   /* nothing is allocated until added */
+   IJSS_assert(!ijss_has(self, 0) && !ijss_has(self, self->sparse_capacity - 1) && !ijss_has(self, self->sparse_capacity));
+   IJSS_assert(sparse_pages.num_allocated_pages == 0);
+   for (i = 0; i != SSHA_NUM_PAGES; ++i)
+      IJSS_assert(page_table[i] == ijss_sparse_empty_page());
+
+   for (i = 0; i != 8192; ++i) {
+      unsigned sparse_index;
+      ijss_test_rand(&rnd);
+      /* clustered in a few pages */
+      sparse_index = ((rnd >> 16) % 5) * 7 * IJSS_SPARSE_PAGE_SIZE + ((rnd >> 8) % 97);
+
+      for (j = 0; j != num_members && members[j] != sparse_index; ++j) {}
+      IJSS_assert(ijss_has(self, sparse_index) == (j != num_members));
+      if (j == num_members) {
+         if (num_members == SSHA_NUM_OBJECTS)
+            continue;
+         IJSS_assert(ijss_add(self, sparse_index) == num_members);
+         members[num_members++] = sparse_index;
+      } else {
+         unsigned move_to, move_from;
+         if (ijss_remove(self, sparse_index, &move_to, &move_from) > 0)
+            members[move_to] = members[move_from];
+         --num_members;
+      }
+
+      IJSS_assert(self->size == num_members);
+      for (j = 0; j != num_members; ++j) {
+         IJSS_assert(ijss_sparse_index(self, j) == members[j]);
+         IJSS_assert(ijss_dense_index(self, members[j]) == j);
+      }
+   }
+   IJSS_assert(sparse_pages.num_allocated_pages == 5);
+
+   /* the fixed width versions of paged sets */
+   for (j = 0; j != num_members; ++j) {
+      IJSS_assert(ijss32_paged_has(self, members[j]) && ijss32_paged_dense_index(self, members[j]) == j);
+      IJSS_assert(ijss32_paged_sparse_index(self, j) == members[j]);
+   }
+   IJSS_assert(!ijss32_paged_has(self, 1 * IJSS_SPARSE_PAGE_SIZE) && !ijss32_paged_has(self, self->sparse_capacity));
+   if (num_members) {
+      unsigned move_to, move_from, sparse_index = members[0];
+      IJSS_assert(ijss32_paged_remove(self, sparse_index, &move_to, &move_from) >= 0);
+      IJSS_assert(!ijss32_paged_has(self, sparse_index));
+      IJSS_assert(ijss32_paged_add(self, sparse_index) == num_members - 1);
+      members[move_to] = members[move_from];
+      members[num_members - 1] = sparse_index;
+   }
+   for (i = 0; i != SSHA_NUM_PAGES; ++i)
+      IJSS_assert((page_table[i] != ijss_sparse_empty_page()) == (i % 7 == 0 && i / 7 < 5));
+
+   /* batch versions works through the page table as well */
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i)
+      indices[i] = i * 131;
+   j = 0;
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i)
+      j += (unsigned)ijss_has(self, indices[i]);
+   IJSS_assert(ijss_has_n(self, indices, SSHA_NUM_OBJECTS, mask) == j);
+
+   /* out of pages */
+   ijss_reset(self);
+   IJSS_assert(ijss_add(self, 2 * IJSS_SPARSE_PAGE_SIZE) == 0);
+   IJSS_assert(sparse_pages.num_allocated_pages == 6);
+   IJSS_assert(ijss_add(self, 3 * IJSS_SPARSE_PAGE_SIZE) == IJSS_INVALID_INDEX);
+   IJSS_assert(self->size == 1);
+   indices[0] = 1;
+   indices[1] = 4 * IJSS_SPARSE_PAGE_SIZE;
+   IJSS_assert(ijss_add_n(self, indices, 2) == IJSS_INVALID_INDEX);
+   IJSS_assert(self->size == 1);
+   IJSS_assert(ijss_add_n(self, indices, 1) == 1);
+   IJSS_assert(ijss_has(self, 1) && ijss_has(self, 2 * IJSS_SPARSE_PAGE_SIZE));
+#undef SSHA_NUM_POOL_PAGES
+#undef SSHA_NUM_PAGES
+#undef SSHA_NUM_OBJECTS
+}
+
+static void ijss_test_sort(void)
+{
+#define SSHA_NUM_OBJECTS (300)
+   struct ijss_pair16 pairs[SSHA_NUM_OBJECTS];
+   unsigned keys[SSHA_NUM_OBJECTS], sorted_keys[SSHA_NUM_OBJECTS];
+   unsigned owners[SSHA_NUM_OBJECTS], sorted_owners[SSHA_NUM_OBJECTS];
+   unsigned permutation[SSHA_NUM_OBJECTS];
+   unsigned scratch[IJSS_SORT_SCRATCH_COUNT(SSHA_NUM_OBJECTS)];
+   struct ijss ss, *self = &ss;
+   unsigned i, round, rnd = 17;
+
+   ijss_init_from_pairtype(struct ijss_pair16, self, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+   ijss_sort(self, 0, permutation, scratch);
+
+   for (round = 0; round != 32; ++round) {
+      /* churn */
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         unsigned move_to, move_from, sparse_index;
+         ijss_test_rand(&rnd);
+         sparse_index = (rnd >> 16) % SSHA_NUM_OBJECTS;
+         if (ijss_has(self, sparse_index)) {
+            if (ijss_remove(self, sparse_index, &move_to, &move_from) > 0) {
+               keys[move_to] = keys[move_from];
+               owners[move_to] = owners[move_from];
+            }
+         } else {
+            unsigned dense_index = ijss_add(self, sparse_index);
+            /* few distinct keys in some rounds to test stability, all digits in others */
+            keys[dense_index] = (round & 1) ? (rnd >> 28) : rnd * 2654435761u;
+            owners[dense_index] = sparse_index;
+         }
+      }
+
+      if (round & 2) {
+         ijss_sort(self, 0, permutation, scratch);
+         for (i = 1; i < self->size; ++i)
+            IJSS_assert(ijss_sparse_index(self, i - 1) < ijss_sparse_index(self, i));
+      } else {
+         ijss_sort(self, keys, permutation, scratch);
+      }
+
+      for (i = 0; i != self->size; ++i) {
+         sorted_keys[i] = keys[permutation[i]];
+         sorted_owners[i] = owners[permutation[i]];
+      }
+      for (i = 0; i != self->size; ++i) {
+         keys[i] = sorted_keys[i];
+         owners[i] = sorted_owners[i];
+         IJSS_assert(ijss_sparse_index(self, i) == owners[i]);
+         IJSS_assert(ijss_dense_index(self, owners[i]) == i);
+         if (!(round & 2) && i > 0) {
+            IJSS_assert(keys[i - 1] <= keys[i]);
+            /* stable */
+            IJSS_assert(keys[i - 1] != keys[i] || permutation[i - 1] < permutation[i]);
+         }
+      }
+   }
+#undef SSHA_NUM_OBJECTS
+}
+
+static void ijss_test_sort_incremental(void)
+{
+#define SSHA_NUM_OBJECTS (200)
+#define SSHA_MAX_COMPARES (37)
+   struct ijss_pair32 pairs[SSHA_NUM_OBJECTS];
+   unsigned keys[SSHA_NUM_OBJECTS], owners[SSHA_NUM_OBJECTS];
+   struct ijss_move swaps[SSHA_MAX_COMPARES];
+   struct ijss_sort_state state = {0, 0};
+   struct ijss ss, *self = &ss;
+   unsigned i, round, rnd = 19;
+
+   ijss_init_from_pairtype(struct ijss_pair32, self, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+
+   for (round = 0; round != 16; ++round) {
+      unsigned num_calls = 0, use_keys = round & 1;
+
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         unsigned move_to, move_from, sparse_index;
+         ijss_test_rand(&rnd);
+         sparse_index = (rnd >> 16) % SSHA_NUM_OBJECTS;
+         if (ijss_has(self, sparse_index)) {
+            if (ijss_remove(self, sparse_index, &move_to, &move_from) > 0) {
+               keys[move_to] = keys[move_from];
+               owners[move_to] = owners[move_from];
+            }
+         } else {
+            unsigned dense_index = ijss_add(self, sparse_index);
+            keys[dense_index] = (rnd >> 8) & 0xff;
+            owners[dense_index] = sparse_index;
+         }
+         /* modifications in between calls */
+         if ((i & 15) == 0) {
+            unsigned j;
+            ijss_sort_incremental(self, &state, use_keys ? keys : 0, 3, swaps);
+            /* the swaps is not applied to owners, refresh them */
+            for (j = 0; j != self->size; ++j)
+               owners[j] = ijss_sparse_index(self, j);
+         }
+      }
+
+      /* the pass in progress started before the modifications, start a new */
+      state.sorted_end = state.position = 0;
+      do {
+         unsigned num_swaps = ijss_sort_incremental(self, &state, use_keys ? keys : 0, SSHA_MAX_COMPARES, swaps);
+         IJSS_assert(num_swaps <= SSHA_MAX_COMPARES);
+         for (i = 0; i != num_swaps; ++i) {
+            unsigned t = owners[swaps[i].to_index];
+            IJSS_assert(swaps[i].to_index + 1 == swaps[i].from_index);
+            owners[swaps[i].to_index] = owners[swaps[i].from_index];
+            owners[swaps[i].from_index] = t;
+         }
+         ++num_calls;
+      } while (state.sorted_end != self->size);
+      IJSS_assert(num_calls > 1);
+
+      for (i = 0; i != self->size; ++i) {
+         IJSS_assert(ijss_sparse_index(self, i) == owners[i]);
+         IJSS_assert(ijss_dense_index(self, owners[i]) == i);
+         if (i > 0) {
+            if (use_keys)
+               IJSS_assert(keys[i - 1] <= keys[i]);
+            else
+               IJSS_assert(owners[i - 1] < owners[i]);
+         }
+      }
+   }
+#undef SSHA_MAX_COMPARES
+#undef SSHA_NUM_OBJECTS
+}
+
+static void ijss_test_partitions(void)
+{
+#define SSHA_NUM_OBJECTS (100)
+#define SSHA_NUM_PARTITIONS (3)
+   struct ijss_pair16 pairs[SSHA_NUM_OBJECTS];
+   unsigned owners[SSHA_NUM_OBJECTS];
+   unsigned partition_of[SSHA_NUM_OBJECTS];
+   struct ijss_move swaps[SSHA_NUM_PARTITIONS];
+   struct ijss_partitions partitions;
+   struct ijss ss, *self = &ss;
+   unsigned i, p, round, rnd = 23;
 
-   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
-      h = ijss_alloc_handle(self, &dense);
-      handles[i] = h;
-      IJSS_assert(ijss_handle_valid(self, h));
+   ijss_init_from_pairtype(struct ijss_pair16, self, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+   for (i = 0; i != 10; ++i) {
+      owners[ijss_add(self, i)] = i;
+      partition_of[i] = 0;
    }
+   ijss_partitions_init(&partitions, self, SSHA_NUM_PARTITIONS);
+
+   for (round = 0; round != 8192; ++round) {
+      unsigned sparse_index, num_swaps, action;
+      ijss_test_rand(&rnd);
+      sparse_index = (rnd >> 16) % SSHA_NUM_OBJECTS;
+      p = (rnd >> 8) % SSHA_NUM_PARTITIONS;
+      action = (rnd >> 12) & 3;
+
+      if (!ijss_has(self, sparse_index)) {
+         num_swaps = ijss_partition_add(&partitions, self, sparse_index, p, swaps);
+         owners[self->size - 1] = sparse_index; /* as it is added at the back */
+         partition_of[sparse_index] = p;
+      } else if (action == 0) {
+         num_swaps = ijss_partition_remove(&partitions, self, sparse_index, swaps);
+      } else {
+         IJSS_assert(ijss_partition_of(&partitions, self, sparse_index) == partition_of[sparse_index]);
+         num_swaps = ijss_move_to_partition(&partitions, self, sparse_index, p, swaps);
+         IJSS_assert(num_swaps <= (p > partition_of[sparse_index] ? p - partition_of[sparse_index] : partition_of[sparse_index] - p));
+         partition_of[sparse_index] = p;
+      }
+      IJSS_assert(num_swaps <= SSHA_NUM_PARTITIONS);
 
-   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
-      IJSS_assert(ijss_handle_valid(self, handles[i]));
-      if (i % 2)
-         continue;
+      for (i = 0; i != num_swaps; ++i) {
+         unsigned t = owners[swaps[i].to_index];
+         owners[swaps[i].to_index] = owners[swaps[i].from_index];
+         owners[swaps[i].from_index] = t;
+      }
 
-      r = ijss_remove(self, i, &move_to, &move_from);
-      IJSS_assert(r >= 0);
-      do_move_data = r > 0;
-      handles[i] = SSHA_INVALID_HANDLE;
+      for (p = 0; p != SSHA_NUM_PARTITIONS; ++p) {
+         IJSS_assert(ijss_partition_begin(&partitions, p) <= ijss_partition_end(&partitions, self, p));
+         for (i = ijss_partition_begin(&partitions, p); i != ijss_partition_end(&partitions, self, p); ++i) {
+            IJSS_assert(owners[i] == ijss_sparse_index(self, i));
+            IJSS_assert(partition_of[owners[i]] == p);
+         }
+      }
    }
 
-   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
-      if (handles[i] == SSHA_INVALID_HANDLE)
-         IJSS_assert(!ijss_handle_valid(self, handles[i]));
-      else
-         IJSS_assert(ijss_handle_valid(self, handles[i]));
+   {
+      /* a failed add on a paged set is not moved into any partition */
+      static unsigned page_memory[1][IJSS_SPARSE_PAGE_SIZE];
+      void *page_table[2];
+      unsigned dense[4];
+      struct ijss_sparse_pages sparse_pages;
+      struct ijss_test_page_pool pool;
+      struct ijss paged;
+
+      pool.memory = (unsigned char*)page_memory;
+      pool.page_size_in_bytes = sizeof page_memory[0];
+      pool.num_pages = 1;
+      pool.num_used = 0;
+      sparse_pages.pages = page_table;
+      sparse_pages.num_pages = 2;
+      sparse_pages.allocate_page = ijss_test_allocate_page;
+      sparse_pages.user_data = &pool;
+      ijss_init_paged(&paged, dense, sizeof *dense, &sparse_pages, sizeof *dense, 4);
+      ijss_partitions_init(&partitions, &paged, SSHA_NUM_PARTITIONS);
+
+      IJSS_assert(ijss_partition_add(&partitions, &paged, 0, 0, swaps) == 0);
+      IJSS_assert(ijss_partition_add(&partitions, &paged, IJSS_SPARSE_PAGE_SIZE, 1, swaps) == IJSS_INVALID_INDEX);
+      IJSS_assert(paged.size == 1 && !ijss_has(&paged, IJSS_SPARSE_PAGE_SIZE));
+      for (p = 0; p != SSHA_NUM_PARTITIONS; ++p)
+         IJSS_assert(ijss_partition_end(&partitions, &paged, p) == 1);
+      IJSS_assert(ijss_partition_of(&partitions, &paged, 0) == 0);
    }
+#undef SSHA_NUM_PARTITIONS
+#undef SSHA_NUM_OBJECTS
+}
 
-   for (i = 0; i != 2; ++i) {
-      h = ijss_alloc_handle(self, &dense);
-      IJSS_assert(handles[h] == SSHA_INVALID_HANDLE);
-      handles[h] = h;
+static void ijss_test_deferred_remove(void)
+{
+#define SSHA_NUM_OBJECTS (128)
+   struct ijss_pair8 pairs[SSHA_NUM_OBJECTS];
+   unsigned owners[SSHA_NUM_OBJECTS];
+   struct ijss_move moves[SSHA_NUM_OBJECTS];
+   unsigned char removed[SSHA_NUM_OBJECTS];
+   unsigned permutation[SSHA_NUM_OBJECTS], sorted_owners[SSHA_NUM_OBJECTS], scratch[IJSS_SORT_SCRATCH_COUNT(SSHA_NUM_OBJECTS)];
+   struct ijss ss, *self = &ss;
+   unsigned i, round, rnd = 29;
+
+   ijss_init_from_pairtype(struct ijss_pair8, self, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+
+   for (round = 0; round != 256; ++round) {
+      unsigned num_moves, num_removed = 0, num_tombstones, old_size, expected_size;
+
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         ijss_test_rand(&rnd);
+         if (!ijss_has(self, i) && ((rnd >> 16) & 1))
+            owners[ijss_add(self, i)] = i;
+         removed[i] = 0;
+      }
+
+      /* remove while iterating, visits all exactly once */
+      for (i = 0; i != self->size; ++i) {
+         unsigned sparse_index;
+         if (ijss_is_tombstone(self, i))
+            continue;
+         sparse_index = ijss_sparse_index(self, i);
+         IJSS_assert(owners[i] == sparse_index);
+         ijss_test_rand(&rnd);
+         if (((rnd >> 16) % 3) == 0) {
+            IJSS_assert(ijss_remove_deferred(self, sparse_index) == 1);
+            IJSS_assert(!ijss_has(self, sparse_index));
+            IJSS_assert(ijss_remove_deferred(self, sparse_index) == 0);
+            IJSS_assert(ijss_is_tombstone(self, i));
+            removed[sparse_index] = 1;
+            ++num_removed;
+            /* re-add some (at the back, visited later) */
+            if (((rnd >> 20) & 3) == 0)
+               owners[ijss_add(self, sparse_index)] = sparse_index;
+         }
+      }
+
+      /* sorting moves the tombstones along, they must stay tombstones */
+      if (round & 1) {
+         ijss_sort(self, 0, permutation, scratch);
+         for (i = 0; i != self->size; ++i)
+            sorted_owners[i] = owners[permutation[i]];
+         for (i = 0; i != self->size; ++i)
+            owners[i] = sorted_owners[i];
+      } else if (round & 2) {
+         struct ijss_sort_state state;
+         state.sorted_end = state.position = 0;
+         do {
+            num_moves = ijss_sort_incremental(self, &state, 0, SSHA_NUM_OBJECTS, moves);
+            for (i = 0; i != num_moves; ++i) {
+               unsigned t = owners[moves[i].to_index];
+               owners[moves[i].to_index] = owners[moves[i].from_index];
+               owners[moves[i].from_index] = t;
+            }
+         } while (state.sorted_end != self->size);
+      }
+      for (i = 0, num_tombstones = 0; i != self->size; ++i) {
+         IJSS_assert(ijss_sparse_index(self, i) == owners[i]);
+         if (ijss_is_tombstone(self, i))
+            ++num_tombstones;
+         else
+            IJSS_assert(ijss_dense_index(self, owners[i]) == i);
+      }
+      IJSS_assert(num_tombstones == num_removed);
+
+      old_size = self->size;
+      expected_size = old_size - num_removed;
+      num_moves = ijss_compact(self, moves);
+      IJSS_assert(self->size == expected_size);
+      IJSS_assert(num_moves <= num_removed);
+      for (i = 0; i != num_moves; ++i) {
+         IJSS_assert(moves[i].to_index < expected_size && moves[i].from_index >= expected_size);
+         owners[moves[i].to_index] = owners[moves[i].from_index];
+      }
+      for (i = 0; i != self->size; ++i) {
+         IJSS_assert(!ijss_is_tombstone(self, i));
+         IJSS_assert(ijss_sparse_index(self, i) == owners[i]);
+         IJSS_assert(ijss_dense_index(self, owners[i]) == i);
+      }
+      for (i = expected_size; i != old_size; ++i)
+         IJSS_assert(removed[ijss_sparse_index(self, i)]);
+
+      /* regular removes after compacting */
+      for (i = 0; i < SSHA_NUM_OBJECTS; i += 5) {
+         unsigned move_to, move_from;
+         if (ijss_remove(self, i, &move_to, &move_from) > 0)
+            owners[move_to] = owners[move_from];
+      }
    }
 
-   r = sizeof do_move_data; /* squashing [-Wunused-but-set-variable] */
+   /* a sort does not bring a tombstone back */
+   ijss_reset(self);
+   ijss_add(self, 5);
+   ijss_add(self, 3);
+   ijss_add(self, 7);
+   IJSS_assert(ijss_remove_deferred(self, 3) == 1);
+   ijss_sort(self, 0, permutation, scratch);
+   IJSS_assert(!ijss_has(self, 3) && self->size == 3);
+   IJSS_assert(ijss_is_tombstone(self, 0) && ijss_sparse_index(self, 1) == 5 && ijss_sparse_index(self, 2) == 7);
+   /* added again, the old slot stays a tombstone */
+   IJSS_assert(ijss_add(self, 3) == 3);
+   ijss_sort(self, 0, permutation, scratch);
+   IJSS_assert(ijss_dense_index(self, 3) == 1 && ijss_is_tombstone(self, 0));
+   IJSS_assert(ijss_compact(self, moves) == 1 && self->size == 3);
+   IJSS_assert(ijss_has(self, 3) && ijss_has(self, 5) && ijss_has(self, 7));
+#undef SSHA_NUM_OBJECTS
+}
 
+#if IJSS_HAS_ATOMICS
+static void ijss_test_add_ts(void)
+{
+#define SSHA_NUM_OBJECTS (64)
+   struct ijss_pair16 pairs[SSHA_NUM_OBJECTS];
+   struct ijss ss, *self = &ss;
+   unsigned i, first;
+
+   ijss_init_from_pairtype(struct ijss_pair16, self, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+
+   IJSS_assert(ijss_add_ts(self, 10) == 0);
+   first = ijss_reserve_ts(self, 40);
+   IJSS_assert(first == 1 && self->size == 41);
+   for (i = 0; i != 40; ++i)
+      ijss_set_pair(self, first + i, 63 - i);
+
+   /* over capacity, size is restored */
+   IJSS_assert(ijss_reserve_ts(self, 24) == IJSS_INVALID_INDEX);
+   IJSS_assert(self->size == 41);
+   IJSS_assert(ijss_reserve_ts(self, 23) == 41);
+   IJSS_assert(ijss_add_ts(self, 0) == IJSS_INVALID_INDEX);
+   self->size = 41;
+
+   IJSS_assert(ijss_has(self, 10) && ijss_dense_index(self, 10) == 0);
+   for (i = 0; i != 40; ++i) {
+      IJSS_assert(ijss_has(self, 63 - i));
+      IJSS_assert(ijss_dense_index(self, 63 - i) == first + i);
+      IJSS_assert(ijss_sparse_index(self, first + i) == 63 - i);
+   }
 #undef SSHA_NUM_OBJECTS
 }
 
-struct ijss_test_orientation {
-   int a;
-   unsigned sparse_owner;
-};
+#if _WIN32
+   #include <process.h>
 
-struct ijss_test_position {
-   int x, y;
-   unsigned sparse_owner;
-};
+   IJSS__EXTERNC_DECL_BEGIN
+      __declspec(dllimport) unsigned long __stdcall WaitForSingleObject(void *hHandle, unsigned long dwMilliseconds);
+      __declspec(dllimport) int __stdcall CloseHandle(void *hObject);
+   IJSS__EXTERNC_DECL_END
+#else
+   #include <pthread.h>
+#endif
 
-struct ijss_test_object {
-   struct ijss_pair32 bookkeeping_position_array;
-   unsigned char somepayload[20];
-   struct ijss_pair8 bookkeeping_orientation_array;
+struct ijss_test_reserver {
+   struct ijss *self;
+   volatile unsigned *start;
+   unsigned num_reserved;
+#if _WIN32
+   void *thread;
+#else
+   pthread_t thread;
+#endif
 };
 
-static void ijss_keep_active_external_data_linear(void)
+#if _WIN32
+static unsigned __stdcall ijss_test_reserver_thread(void *arg)
+#else
+static void *ijss_test_reserver_thread(void *arg)
+#endif
 {
-#define SSHA_NUM_OBJECTS (16)
-   unsigned i;
-   int loop;
-   struct ijss ss_positions;
-   struct ijss ss_orientations;
-   struct ijss_test_object all_test_objects[SSHA_NUM_OBJECTS] = {0};
-   struct ijss_test_orientation all_orientations_array[SSHA_NUM_OBJECTS];
-   struct ijss_test_position all_positions_array[SSHA_NUM_OBJECTS];
-
-   ijss_init_from_pairtype(struct ijss_pair32,
-                           &ss_positions,
-                           (unsigned char*)all_test_objects + ijss_test_offsetof(struct ijss_test_object, bookkeeping_position_array),
-                           sizeof(struct ijss_test_object),
-                           SSHA_NUM_OBJECTS);
+   struct ijss_test_reserver *reserver = (struct ijss_test_reserver*)arg;
+   struct ijss *self = reserver->self;
+   unsigned i, first, n = 3;
+
+   while (!*reserver->start) {}
+   while (n) {
+      first = ijss_reserve_ts(self, n);
+      if (first == IJSS_INVALID_INDEX) {
+         /* only fails when there really is less than 'n' left */
+         IJSS_assert(self->capacity - *(volatile unsigned*)&self->size < n);
+         --n;
+         continue;
+      }
+      IJSS_assert(first + n <= self->capacity);
+      for (i = 0; i != n; ++i)
+         ijss_set_pair(self, first + i, first + i);
+      reserver->num_reserved += n;
+   }
+   return 0;
+}
 
-   ijss_init_from_pairtype(struct ijss_pair8,
-                           &ss_orientations,
-                           (unsigned char*)all_test_objects + ijss_test_offsetof(struct ijss_test_object, bookkeeping_orientation_array),
-                           sizeof(struct ijss_test_object),
-                           SSHA_NUM_OBJECTS);
+static void ijss_test_reserve_ts_threaded(void)
+{
+#define SSHA_NUM_OBJECTS (256)
+#define SSHA_NUM_THREADS (4)
+   struct ijss_pair16 pairs[SSHA_NUM_OBJECTS];
+   struct ijss_test_reserver reservers[SSHA_NUM_THREADS];
+   struct ijss ss, *self = &ss;
+   volatile unsigned start;
+   unsigned i, round, num_reserved;
+
+   ijss_init_from_pairtype(struct ijss_pair16, self, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+
+   for (round = 0; round != 256; ++round) {
+      self->size = 0;
+      start = 0;
+      for (i = 0; i != SSHA_NUM_THREADS; ++i) {
+         reservers[i].self = self;
+         reservers[i].start = &start;
+         reservers[i].num_reserved = 0;
+#if _WIN32
+         reservers[i].thread = (void*)_beginthreadex(0, 0, ijss_test_reserver_thread, &reservers[i], 0, 0);
+         IJSS_assert(reservers[i].thread != 0);
+#else
+         IJSS_assert(pthread_create(&reservers[i].thread, 0, ijss_test_reserver_thread, &reservers[i]) == 0);
+#endif
+      }
+      start = 1;
+      num_reserved = 0;
+      for (i = 0; i != SSHA_NUM_THREADS; ++i) {
+#if _WIN32
+         WaitForSingleObject(reservers[i].thread, 0xffffffff);
+         CloseHandle(reservers[i].thread);
+#else
+         pthread_join(reservers[i].thread, 0);
+#endif
+         num_reserved += reservers[i].num_reserved;
+      }
 
-   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
-      IJSS_assert(!ijss_has(&ss_positions, i));
-      IJSS_assert(!ijss_has(&ss_orientations, i));
+      /* every slot is handed out exactly once and 'size' never passed the capacity */
+      IJSS_assert(num_reserved == SSHA_NUM_OBJECTS);
+      IJSS_assert(self->size == SSHA_NUM_OBJECTS);
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         IJSS_assert(ijss_has(self, i));
+         IJSS_assert(ijss_dense_index(self, i) == i);
+      }
    }
+#undef SSHA_NUM_THREADS
+#undef SSHA_NUM_OBJECTS
+}
+#endif
 
-   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
-      unsigned dense;
-      if (i & 1) {
-         IJSS_assert(!ijss_has(&ss_positions, i));
-         dense = ijss_add(&ss_positions, i);
-         all_positions_array[dense].sparse_owner = i;
-         all_positions_array[dense].x = all_positions_array[dense].y = 0;
-         IJSS_assert(ijss_has(&ss_positions, i));
-      } else {
-         IJSS_assert(!ijss_has(&ss_orientations, i));
-         dense = ijss_add(&ss_orientations, i);
-         all_orientations_array[dense].sparse_owner = i;
-         all_orientations_array[dense].a = 0;
-         IJSS_assert(ijss_has(&ss_orientations, i));
+struct ijss_test_parallel_for {
+   unsigned char visited[1000];
+   unsigned chunk_size;
+   unsigned num_calls;
+};
+
+static void ijss_test_parallel_for_range(void *user_data, unsigned begin, unsigned end)
+{
+   struct ijss_test_parallel_for *data = (struct ijss_test_parallel_for *)user_data;
+   IJSS_assert(begin % data->chunk_size == 0 && begin < end && end - begin <= data->chunk_size);
+   for (; begin != end; ++begin)
+      data->visited[begin]++;
+   data->num_calls++;
+}
+
+/* a "pool" that runs the tasks in reverse order */
+static void ijss_test_dispatch(void *pool, void (*task)(void *task_data, unsigned task_index), void *task_data, unsigned num_tasks)
+{
+   unsigned *num_dispatches = (unsigned *)pool;
+   ++*num_dispatches;
+   while (num_tasks)
+      task(task_data, --num_tasks);
+}
+
+static void ijss_test_parallel_for(void)
+{
+   struct ijss_pair16 pairs[16];
+   struct ijss_pair32 pairs32[16];
+   struct ijss ss16, ss32;
+   struct ijss *sets[2];
+   struct ijss_test_parallel_for data;
+   unsigned strides[2], i, count, num_dispatches = 0;
+
+   ijss_init_from_pairtype(struct ijss_pair16, &ss16, pairs, sizeof *pairs, 16);
+   ijss_init_from_pairtype(struct ijss_pair32, &ss32, pairs32, sizeof *pairs32, 16);
+   sets[0] = &ss16;
+   sets[1] = &ss32;
+
+   /* 4 byte stride -> 16 per cache line, 8 -> 8, 12 -> 16, 24 -> 8, 64 and 128 -> 1 */
+   IJSS_assert(ijss_chunk_size(sets, 1, 0, 0, 1) == IJSS_CACHE_LINE_SIZE / 4);
+   IJSS_assert(ijss_chunk_size(sets + 1, 1, 0, 0, 1) == IJSS_CACHE_LINE_SIZE / 8);
+   strides[0] = 24;
+   strides[1] = 12;
+   IJSS_assert(ijss_chunk_size(0, 0, strides, 1, 1) == IJSS_CACHE_LINE_SIZE / 8);
+   IJSS_assert(ijss_chunk_size(0, 0, strides, 2, 1) == IJSS_CACHE_LINE_SIZE / 4);
+   IJSS_assert(ijss_chunk_size(sets + 1, 1, strides, 1, 100) == 104);
+   strides[0] = IJSS_CACHE_LINE_SIZE;
+   strides[1] = IJSS_CACHE_LINE_SIZE * 2;
+   IJSS_assert(ijss_chunk_size(0, 0, strides, 2, 1) == 1);
+   IJSS_assert(ijss_chunk_size(0, 0, strides, 2, 7) == 7);
+
+   for (count = 0; count < 1000; count += 37) {
+      unsigned d;
+      for (d = 0; d != 2; ++d) {
+         data.chunk_size = ijss_chunk_size(sets, 2, strides, 1, 50);
+         data.num_calls = 0;
+         for (i = 0; i != count; ++i)
+            data.visited[i] = 0;
+         ijss_parallel_for(count, data.chunk_size, ijss_test_parallel_for_range, &data, d ? ijss_test_dispatch : 0, &num_dispatches);
+         IJSS_assert(data.num_calls == (count + data.chunk_size - 1) / data.chunk_size);
+         for (i = 0; i != count; ++i)
+            IJSS_assert(data.visited[i] == 1);
       }
    }
+   IJSS_assert(num_dispatches == 999 / 37);
+}
 
-   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
-      if (i & 1) {
-         IJSS_assert(!ijss_has(&ss_orientations, i));
-         IJSS_assert(ijss_has(&ss_positions, i));
-      } else {
-         IJSS_assert(!ijss_has(&ss_positions, i));
-         IJSS_assert(ijss_has(&ss_orientations, i));
+static void ijss_test_versions(void)
+{
+#define SSHA_NUM_OBJECTS (500)
+   struct ijss_pair16 pairs[SSHA_NUM_OBJECTS];
+   unsigned versions[SSHA_NUM_OBJECTS];
+   unsigned block_versions[IJSS_VERSIONS_NUM_BLOCKS(SSHA_NUM_OBJECTS)];
+   unsigned touched_in[SSHA_NUM_OBJECTS]; /* per sparse index */
+   struct ijss_versions v;
+   struct ijss ss, *self = &ss;
+   unsigned i, round, since = 1, rnd = 31;
+
+   ijss_init_from_pairtype(struct ijss_pair16, self, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+   ijss_versions_init(&v, versions, block_versions, SSHA_NUM_OBJECTS);
+   IJSS_assert(ijss_next_changed(self, &v, 0, since) == 0);
+
+   for (round = 0; round != 64; ++round) {
+      unsigned num_changed = 0, num_expected = 0;
+
+      for (i = 0; i != 50; ++i) {
+         unsigned sparse_index, move_to, move_from;
+         ijss_test_rand(&rnd);
+         sparse_index = (rnd >> 16) % SSHA_NUM_OBJECTS;
+         if (!ijss_has(self, sparse_index)) {
+            ijss_add_versioned(self, &v, sparse_index);
+            touched_in[sparse_index] = v.version;
+         } else if ((rnd >> 8) & 1) {
+            ijss_touch(&v, ijss_dense_index(self, sparse_index));
+            touched_in[sparse_index] = v.version;
+         } else {
+            ijss_remove_versioned(self, &v, sparse_index, &move_to, &move_from);
+         }
+      }
+      if ((round & 1) && self->size) {
+         unsigned a, b;
+         ijss_test_rand(&rnd);
+         a = (rnd >> 16) % self->size;
+         b = (rnd >> 8) % self->size;
+         ijss_swap(self, a, b);
+         ijss_versions_swap(&v, a, b);
+      }
+
+      for (i = ijss_next_changed(self, &v, 0, since); i != self->size; i = ijss_next_changed(self, &v, i + 1, since)) {
+         IJSS_assert(touched_in[ijss_sparse_index(self, i)] >= since);
+         ++num_changed;
+      }
+      for (i = 0; i != self->size; ++i) {
+         IJSS_assert(versions[i] == touched_in[ijss_sparse_index(self, i)]);
+         num_expected += touched_in[ijss_sparse_index(self, i)] >= since;
       }
+      IJSS_assert(num_changed == num_expected);
+
+      /* every 4th round the consumer catches up */
+      ijss_versions_advance(&v);
+      if ((round & 3) == 3)
+         since = v.version;
    }
+#undef SSHA_NUM_OBJECTS
+}
 
-   /* now we have added the objects into either the position or orientation arrays */
-   loop = 0;
+struct ijss_test_column_object {
+   unsigned char payload[3];
+   unsigned char c1;
+   unsigned short c2;
+   unsigned c4;
+   unsigned c8[2];
+   unsigned char c5[5];
+};
 
-   while (ss_orientations.size) {
+static void ijss_test_columns(void)
+{
+#define SSHA_NUM_OBJECTS (100)
+#define SSHA_CHECK_COLUMNS() \
+   for (i = 0; i != self->size; ++i) { \
+      unsigned x = ijss_sparse_index(self, i); \
+      IJSS_assert(objects[i].c1 == (unsigned char)(x + 1)); \
+      IJSS_assert(objects[i].c2 == (unsigned short)(x + 2)); \
+      IJSS_assert(objects[i].c4 == x + 4); \
+      IJSS_assert(objects[i].c8[0] == x + 8 && objects[i].c8[1] == ~x); \
+      IJSS_assert(objects[i].c5[0] == (unsigned char)(x + 5) && objects[i].c5[4] == (unsigned char)(x + 9)); \
+      IJSS_assert(packed[i] == x); \
+   }
 
-      for (i = 0; i != ss_orientations.size; ++i) {
-         struct ijss_test_orientation *current = all_orientations_array + i;
-         IJSS_assert(ijss_has(&ss_orientations, current->sparse_owner));
-         IJSS_assert(ijss_dense_index(&ss_orientations, current->sparse_owner) == i);
-         IJSS_assert(ijss_sparse_index(&ss_orientations, i) == current->sparse_owner);
-         IJSS_assert(current->a == loop);
+   struct ijss_test_column_object objects[SSHA_NUM_OBJECTS];
+   unsigned packed[SSHA_NUM_OBJECTS];
+   struct ijss_pair16 pairs[SSHA_NUM_OBJECTS];
+   unsigned indices[SSHA_NUM_OBJECTS];
+   struct ijss_move moves[SSHA_NUM_OBJECTS];
+   unsigned permutation[SSHA_NUM_OBJECTS];
+   unsigned sort_scratch[IJSS_SORT_SCRATCH_COUNT(SSHA_NUM_OBJECTS)];
+   struct ijss_test_column_object column_scratch[SSHA_NUM_OBJECTS];
+   struct ijss_columns columns;
+   struct ijss ss, *self = &ss;
+   unsigned i, round, rnd = 37;
+
+   ijss_init_from_pairtype(struct ijss_pair16, self, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+   ijss_columns_init(&columns, self);
+   IJSS_assert(ijss_columns_register(&columns, &objects[0].c1, 1, sizeof *objects) == 0);
+   ijss_columns_register(&columns, &objects[0].c2, 2, sizeof *objects);
+   ijss_columns_register(&columns, &objects[0].c4, 4, sizeof *objects);
+   ijss_columns_register(&columns, &objects[0].c8, 8, sizeof *objects);
+   ijss_columns_register(&columns, &objects[0].c5, 5, sizeof *objects);
+   IJSS_assert(ijss_columns_register(&columns, packed, sizeof *packed, sizeof *packed) == 5);
+
+   for (round = 0; round != 128; ++round) {
+      unsigned n = 0;
+      for (i = 0; i != 20; ++i) {
+         unsigned x, d;
+         ijss_test_rand(&rnd);
+         x = (rnd >> 16) % SSHA_NUM_OBJECTS;
+         if (ijss_has(self, x)) {
+            IJSS_assert(ijss_columns_remove(&columns, x) >= 0);
+            continue;
+         }
+         d = ijss_columns_add(&columns, x);
+         objects[d].c1 = (unsigned char)(x + 1);
+         objects[d].c2 = (unsigned short)(x + 2);
+         objects[d].c4 = x + 4;
+         objects[d].c8[0] = x + 8;
+         objects[d].c8[1] = ~x;
+         objects[d].c5[0] = (unsigned char)(x + 5);
+         objects[d].c5[4] = (unsigned char)(x + 9);
+         packed[d] = x;
       }
+      SSHA_CHECK_COLUMNS()
 
-      for (i = 0; i != ss_positions.size; ++i) {
-         struct ijss_test_position *current = all_positions_array + i;
-         IJSS_assert(ijss_has(&ss_positions, current->sparse_owner));
-         IJSS_assert(ijss_dense_index(&ss_positions, current->sparse_owner) == i);
-         IJSS_assert(ijss_sparse_index(&ss_positions, i) == current->sparse_owner);
-         IJSS_assert(current->x == loop);
-         IJSS_assert(current->y == loop);
+      switch (round & 3) {
+         case 0:
+            for (i = 0; i != 10; ++i) {
+               ijss_test_rand(&rnd);
+               indices[n++] = (rnd >> 16) % SSHA_NUM_OBJECTS;
+            }
+            ijss_columns_remove_n(&columns, indices, n, moves);
+            break;
+         case 1:
+            for (i = 0; i < self->size; i += 3)
+               n += (unsigned)ijss_remove_deferred(self, ijss_sparse_index(self, i));
+            ijss_columns_compact(&columns, moves);
+            break;
+         case 2:
+            ijss_columns_sort(&columns, 0, permutation, sort_scratch, column_scratch);
+            for (i = 1; i < self->size; ++i)
+               IJSS_assert(ijss_sparse_index(self, i - 1) < ijss_sparse_index(self, i));
+            break;
+         default:
+            n = self->size / 2;
+            for (i = 0; i != n; ++i) {
+               moves[i].to_index = i;
+               moves[i].from_index = self->size - 1 - i;
+               ijss_swap(self, i, self->size - 1 - i);
+            }
+            ijss_columns_apply_swaps(&columns, moves, n);
+            break;
       }
+      SSHA_CHECK_COLUMNS()
+   }
+#undef SSHA_CHECK_COLUMNS
+#undef SSHA_NUM_OBJECTS
+}
 
-      /* now remove the first of each array */
-      {
-         int r, do_move_data;
-         unsigned move_from, move_to;
-         unsigned sparse_indices[2];
-         sparse_indices[0] = all_orientations_array[0].sparse_owner;
-         sparse_indices[1] = all_positions_array[0].sparse_owner;
-         for (i = 0; i != 2; ++i) {
-            unsigned sparse_index = sparse_indices[i];
-            if (i & 1) {
-               IJSS_assert(!ijss_has(&ss_orientations, sparse_index));
-               IJSS_assert(ijss_has(&ss_positions, sparse_index));
-               r = ijss_remove(&ss_positions, sparse_index, &move_to, &move_from);
-               IJSS_assert(r >= 0);
-               do_move_data = r > 0;
-               IJSS_assert(do_move_data || ss_positions.size == 0); /* otherwise the test is setup incorrectly */
-               all_positions_array[move_to] = all_positions_array[move_from];
-            } else {
-               IJSS_assert(!ijss_has(&ss_positions, sparse_index));
-               IJSS_assert(ijss_has(&ss_orientations, sparse_index));
-               r = ijss_remove(&ss_orientations, sparse_index, &move_to, &move_from);
-               IJSS_assert(r >= 0);
-               do_move_data = r > 0;
-               IJSS_assert(do_move_data || ss_orientations.size == 0); /* otherwise the test is setup incorrectly */
-               all_orientations_array[move_to] = all_orientations_array[move_from];
-            }
-         }
+static void ijss_test_64(void)
+{
+#define SSHA_NUM_OBJECTS (64)
+#define SSHA_NUM_PAGES (1024)
+#define SSHA_NUM_POOL_PAGES (4)
+   static unsigned page_memory[SSHA_NUM_POOL_PAGES][IJSS_SPARSE_PAGE_SIZE]; /* 4 byte dense indices */
+   static void *page_table[SSHA_NUM_PAGES];
+   struct ijss_pair64 pairs[SSHA_NUM_OBJECTS];
+   struct ijss_pair64 dense_pairs[SSHA_NUM_OBJECTS];
+   ijss_uint64 members[SSHA_NUM_OBJECTS];
+   struct ijss_sparse_pages sparse_pages;
+   struct ijss_test_page_pool pool;
+   struct ijss flat, paged;
+   unsigned i, j, num_members = 0, rnd = 41;
+
+   ijss_init_from_pairtype(struct ijss_pair64, &flat, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i)
+      IJSS_assert(ijss64_add(&flat, SSHA_NUM_OBJECTS - 1 - i) == i);
+   IJSS_assert(!ijss64_has(&flat, SSHA_NUM_OBJECTS) && !ijss64_has(&flat, (ijss_uint64)1 << 40));
+   for (i = 0; i != SSHA_NUM_OBJECTS; i += 2) {
+      unsigned move_to, move_from;
+      IJSS_assert(ijss64_remove(&flat, i, &move_to, &move_from) >= 0);
+   }
+   for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+      IJSS_assert(ijss64_has(&flat, i) == (int)(i & 1));
+      if (i & 1)
+         IJSS_assert(ijss64_sparse_index(&flat, ijss64_dense_index(&flat, i)) == i);
+   }
+
+   /* the generic single element and lookup functions forwards to the 64-bit versions */
+   {
+      unsigned sparse_indices[SSHA_NUM_OBJECTS], dense_out[SSHA_NUM_OBJECTS], mask[SSHA_NUM_OBJECTS / 32];
+      unsigned move_to, move_from;
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         sparse_indices[i] = i;
+         IJSS_assert(ijss_has(&flat, i) == (int)(i & 1));
+         if (i & 1)
+            IJSS_assert(ijss_sparse_index(&flat, ijss_dense_index(&flat, i)) == i);
+      }
+      IJSS_assert(ijss_has_n(&flat, sparse_indices, SSHA_NUM_OBJECTS, mask) == SSHA_NUM_OBJECTS / 2);
+      IJSS_assert(ijss_dense_index_n(&flat, sparse_indices, SSHA_NUM_OBJECTS, dense_out) == SSHA_NUM_OBJECTS / 2);
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         IJSS_assert(((mask[i >> 5] >> (i & 31)) & 1) == (i & 1));
+         IJSS_assert(dense_out[i] == ((i & 1) ? ijss64_dense_index(&flat, i) : IJSS_INVALID_INDEX));
       }
+      IJSS_assert(ijss_add(&flat, 0) == SSHA_NUM_OBJECTS / 2 && ijss64_has(&flat, 0));
+      IJSS_assert(ijss_remove(&flat, 0, &move_to, &move_from) == 0 && !ijss64_has(&flat, 0));
+   }
 
-      /* now loop the linear data again and verify */
-      for (i = 0; i != ss_orientations.size; ++i) {
-         struct ijss_test_orientation *current = all_orientations_array + i;
-         IJSS_assert(ijss_has(&ss_orientations, current->sparse_owner));
-         IJSS_assert(ijss_dense_index(&ss_orientations, current->sparse_owner) == i);
-         IJSS_assert(ijss_sparse_index(&ss_orientations, i) == current->sparse_owner);
-         IJSS_assert(current->a == loop);
-         current->a++;
+   /* paged, with sparse indices far apart */
+   pool.memory = (unsigned char*)page_memory;
+   pool.page_size_in_bytes = sizeof page_memory[0];
+   pool.num_pages = SSHA_NUM_POOL_PAGES;
+   pool.num_used = 0;
+   sparse_pages.pages = page_table;
+   sparse_pages.num_pages = SSHA_NUM_PAGES;
+   sparse_pages.allocate_page = ijss_test_allocate_page;
+   sparse_pages.user_data = &pool;
+   /* only the dense side of the pairs is used */
+   ijss_init_paged(&paged, dense_pairs, sizeof *dense_pairs, &sparse_pages, 8, SSHA_NUM_OBJECTS);
+
+   for (i = 0; i != 2048; ++i) {
+      ijss_uint64 sparse_index;
+      ijss_test_rand(&rnd);
+      sparse_index = (ijss_uint64)(((rnd >> 16) & 3) * 300) * IJSS_SPARSE_PAGE_SIZE + ((rnd >> 8) & 63);
+
+      for (j = 0; j != num_members && members[j] != sparse_index; ++j) {}
+      IJSS_assert(ijss64_has(&paged, sparse_index) == (j != num_members));
+      if (j == num_members) {
+         if (num_members == SSHA_NUM_OBJECTS)
+            continue;
+         IJSS_assert(ijss64_add(&paged, sparse_index) == num_members);
+         members[num_members++] = sparse_index;
+      } else {
+         unsigned move_to, move_from;
+         if (ijss64_remove(&paged, sparse_index, &move_to, &move_from) > 0)
+            members[move_to] = members[move_from];
+         --num_members;
       }
+      for (j = 0; j != num_members; ++j) {
+         IJSS_assert(ijss64_sparse_index(&paged, j) == members[j]);
+         IJSS_assert(ijss64_dense_index(&paged, members[j]) == j);
+         IJSS_assert(ijss_has(&paged, (unsigned)members[j]) && ijss_dense_index(&paged, (unsigned)members[j]) == j);
+      }
+   }
+   IJSS_assert(sparse_pages.num_allocated_pages == 4);
+   IJSS_assert(!ijss64_has(&paged, (ijss_uint64)SSHA_NUM_PAGES * IJSS_SPARSE_PAGE_SIZE));
+   IJSS_assert(!ijss64_has(&paged, ((ijss_uint64)1 << 32) + 1));
+
+   /* a build on the allocated pages */
+   {
+      unsigned sparse_indices[3];
+      sparse_indices[0] = 300 * IJSS_SPARSE_PAGE_SIZE + 1;
+      sparse_indices[1] = 5;
+      sparse_indices[2] = 900 * IJSS_SPARSE_PAGE_SIZE;
+      IJSS_assert(ijss_build(&paged, sparse_indices, 3) == 1);
+      for (i = 0; i != 3; ++i)
+         IJSS_assert(ijss64_dense_index(&paged, sparse_indices[i]) == i && ijss64_sparse_index(&paged, i) == sparse_indices[i]);
+      IJSS_assert(paged.size == 3 && !ijss64_has(&paged, 6));
+   }
+#undef SSHA_NUM_POOL_PAGES
+#undef SSHA_NUM_PAGES
+#undef SSHA_NUM_OBJECTS
+}
 
-      for (i = 0; i != ss_positions.size; ++i) {
-         struct ijss_test_position *current = all_positions_array + i;
-         IJSS_assert(ijss_has(&ss_positions, current->sparse_owner));
-         IJSS_assert(ijss_dense_index(&ss_positions, current->sparse_owner) == i);
-         IJSS_assert(ijss_sparse_index(&ss_positions, i) == current->sparse_owner);
-         IJSS_assert(current->x == loop);
-         IJSS_assert(current->y == loop);
-         current->x++;
-         current->y++;
+static void ijss_test_build(void)
+{
+#define SSHA_NUM_OBJECTS (IJSS_BUILD_STREAM_THRESHOLD + 100)
+   static unsigned dense[SSHA_NUM_OBJECTS], sparse[SSHA_NUM_OBJECTS], indices[SSHA_NUM_OBJECTS];
+   struct ijss_pair8 pairs8[200];
+   struct ijss_pair16 pairs16[200];
+   struct ijss_pair64 pairs64[200];
+   struct ijss sets[4];
+   unsigned s, i, rnd = 43;
+
+   ijss_init_from_pairtype(struct ijss_pair8, &sets[0], pairs8, sizeof *pairs8, 200);
+   ijss_init_from_pairtype(struct ijss_pair16, &sets[1], pairs16, sizeof *pairs16, 200);
+   ijss_init(&sets[2], dense, sizeof *dense, sparse, sizeof *sparse, sizeof *dense, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair64, &sets[3], pairs64, sizeof *pairs64, 200);
+
+   for (s = 0; s != 4; ++s) {
+      struct ijss *self = &sets[s];
+      unsigned n;
+
+      /* shuffled identity, partially used */
+      for (i = 0; i != self->capacity; ++i)
+         indices[i] = i;
+      for (i = self->capacity - 1; i > 0; --i) {
+         unsigned j, t;
+         ijss_test_rand(&rnd);
+         j = (rnd >> 8) % (i + 1);
+         t = indices[i]; indices[i] = indices[j]; indices[j] = t;
+      }
+
+      ijss_add(self, indices[0]);
+      /* the last build is of the whole capacity */
+      for (n = 0;; n += self->capacity / 3) {
+         if (n > self->capacity)
+            n = self->capacity;
+         IJSS_assert(ijss_build(self, indices, n) == 1);
+         IJSS_assert(self->size == n);
+         for (i = 0; i != n; ++i) {
+            IJSS_assert(ijss_has(self, indices[i]));
+            IJSS_assert(ijss_dense_index(self, indices[i]) == i);
+            IJSS_assert(ijss_sparse_index(self, i) == indices[i]);
+         }
+         for (i = n; i != self->capacity; ++i)
+            IJSS_assert(!ijss_has(self, indices[i]));
+         if (n == self->capacity)
+            break;
       }
-      ++loop;
    }
 #undef SSHA_NUM_OBJECTS
+}
+
+static void ijss_test_serialize(void)
+{
+#define SSHA_NUM_OBJECTS (1000)
+   static unsigned char buffer[IJSS_SERIALIZE_MAX_SIZE(SSHA_NUM_OBJECTS)];
+   static struct ijss_pair16 pairs[SSHA_NUM_OBJECTS], loaded_pairs[SSHA_NUM_OBJECTS];
+   static unsigned permutation[SSHA_NUM_OBJECTS], scratch[IJSS_SORT_SCRATCH_COUNT(SSHA_NUM_OBJECTS)];
+   struct ijss_pair8 small_pairs[16];
+   struct ijss ss, loaded, small;
+   unsigned i, round, num_bytes, rnd = 47;
+
+   ijss_init_from_pairtype(struct ijss_pair16, &ss, pairs, sizeof *pairs, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair16, &loaded, loaded_pairs, sizeof *loaded_pairs, SSHA_NUM_OBJECTS);
+   ijss_init_from_pairtype(struct ijss_pair8, &small, small_pairs, sizeof *small_pairs, 16);
+
+   for (round = 0; round != 8; ++round) {
+      unsigned flags = round & 1 ? IJSS_SERIALIZE_DELTA_VARINT : 0, num_needed;
+
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i) {
+         ijss_test_rand(&rnd);
+         if (((rnd >> 16) & 7) < round && !ijss_has(&ss, i))
+            ijss_add(&ss, i);
+      }
+      if (round & 2)
+         ijss_sort(&ss, 0, permutation, scratch);
+
+      num_needed = ijss_serialize(&ss, flags, 0, 0);
+      IJSS_assert(num_needed <= IJSS_SERIALIZE_MAX_SIZE(ss.size));
+      IJSS_assert(ijss_serialize(&ss, flags, buffer, num_needed - 1) == num_needed);
+      num_bytes = ijss_serialize(&ss, flags, buffer, sizeof buffer);
+      IJSS_assert(num_bytes == num_needed);
+      if (!flags)
+         IJSS_assert(num_bytes == IJSS_SERIALIZE_HEADER_SIZE + ss.size * 2);
+      else if (round & 2)
+         IJSS_assert(num_bytes <= IJSS_SERIALIZE_HEADER_SIZE + ss.size); /* sorted, small deltas */
+
+      IJSS_assert(ijss_deserialize(&loaded, buffer, num_bytes) == num_bytes);
+      IJSS_assert(loaded.size == ss.size);
+      for (i = 0; i != ss.size; ++i)
+         IJSS_assert(ijss_sparse_index(&loaded, i) == ijss_sparse_index(&ss, i));
+      for (i = 0; i != SSHA_NUM_OBJECTS; ++i)
+         IJSS_assert(ijss_has(&loaded, i) == ijss_has(&ss, i));
+
+      /* truncated */
+      if (ss.size) {
+         IJSS_assert(ijss_deserialize(&loaded, buffer, num_bytes - 1) == 0);
+         IJSS_assert(loaded.size == 0);
+      }
+      /* too many or out of range for the small set */
+      IJSS_assert(ss.size <= 16 || ijss_deserialize(&small, buffer, num_bytes) == 0);
+   }
+
+   /* duplicates */
+   ijss_reset(&ss);
+   ijss_add(&ss, 5);
+   ijss_add(&ss, 6);
+   num_bytes = ijss_serialize(&ss, 0, buffer, sizeof buffer);
+   buffer[IJSS_SERIALIZE_HEADER_SIZE + 2] = 5;
+   IJSS_assert(ijss_deserialize(&loaded, buffer, num_bytes) == 0);
+   buffer[IJSS_SERIALIZE_HEADER_SIZE + 2] = 6;
+   IJSS_assert(ijss_deserialize(&small, buffer, num_bytes) == num_bytes);
+   IJSS_assert(ijss_has(&small, 5) && ijss_has(&small, 6) && small.size == 2);
+
+   /* tombstones left by a deferred remove is not written */
+   ijss_reset(&ss);
+   for (i = 0; i != 10; ++i)
+      ijss_add(&ss, i * 3);
+   ijss_remove_deferred(&ss, 0);
+   ijss_remove_deferred(&ss, 12);
+   ijss_remove_deferred(&ss, 27);
+   for (round = 0; round != 2; ++round) {
+      unsigned flags = round ? IJSS_SERIALIZE_DELTA_VARINT : 0;
+      num_bytes = ijss_serialize(&ss, flags, buffer, sizeof buffer);
+      IJSS_assert(flags || num_bytes == IJSS_SERIALIZE_HEADER_SIZE + 7 * 2);
+      IJSS_assert(ijss_deserialize(&loaded, buffer, num_bytes) == num_bytes);
+      IJSS_assert(loaded.size == 7);
+      for (i = 0; i != 10; ++i)
+         IJSS_assert(ijss_has(&loaded, i * 3) == (i != 0 && i != 4 && i != 9));
+   }
 
+   /* a 5th varint byte with more than the 4 bits left is corrupt */
+   buffer[0] = IJSS_SERIALIZE_DELTA_VARINT;
+   buffer[1] = 2;
+   buffer[2] = 1; buffer[3] = buffer[4] = buffer[5] = 0;
+   for (i = 0; i != 4; ++i)
+      buffer[IJSS_SERIALIZE_HEADER_SIZE + i] = 0x80;
+   buffer[IJSS_SERIALIZE_HEADER_SIZE + 4] = 0x00;
+   IJSS_assert(ijss_deserialize(&loaded, buffer, IJSS_SERIALIZE_HEADER_SIZE + 5) == IJSS_SERIALIZE_HEADER_SIZE + 5);
+   IJSS_assert(loaded.size == 1 && ijss_has(&loaded, 0));
+   buffer[IJSS_SERIALIZE_HEADER_SIZE + 4] = 0x10;
+   IJSS_assert(ijss_deserialize(&loaded, buffer, IJSS_SERIALIZE_HEADER_SIZE + 5) == 0);
+   IJSS_assert(loaded.size == 0);
+#undef SSHA_NUM_OBJECTS
 }
+
 static void ijss_test_suite(void)
 {
    ijss_as_handlealloc_test_suite();
    ijss_keep_active_external_data_linear();
+   ijss_test_fixed_width();
+   ijss_test_add_remove_n();
+   ijss_test_has_n();
+   ijss_test_join();
+   ijss_test_group();
+   ijss_test_paged();
+   ijss_test_sort();
+   ijss_test_sort_incremental();
+   ijss_test_partitions();
+   ijss_test_deferred_remove();
+#if IJSS_HAS_ATOMICS
+   ijss_test_add_ts();
+   ijss_test_reserve_ts_threaded();
+#endif
+   ijss_test_parallel_for();
+   ijss_test_versions();
+   ijss_test_columns();
+   ijss_test_64();
+   ijss_test_build();
+   ijss_test_serialize();
 }
 
 #if defined(IJSS_TEST_MAIN)